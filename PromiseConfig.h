@@ -20,5 +20,89 @@
 # define ONREJECT_IMPLICITLY_RESOLVED 1
 #endif // ONREJECT_IMPLICITLY_RESOLVED
 
+/*
+ * slots of the ring reused by each `RecursionPromise` for its trivially copyable values
+ *  0 to allocate every value from the heap
+ */
+#ifndef RECURSION_VALUE_RING_SIZE
+# define RECURSION_VALUE_RING_SIZE 64
+#endif // RECURSION_VALUE_RING_SIZE
+
+/*
+ * records node create, chain, settle, schedule and run into per-thread buffers
+ *  `Promise2::Tracing::dump` writes them as chrome trace event JSON, nothing compiled in if 0
+ */
+#ifndef PROMISE_TRACING
+# define PROMISE_TRACING 0
+#endif // PROMISE_TRACING
+
+/*
+ * events kept by each thread buffer, the rest are dropped and counted
+ * a buffer left by an exited thread is taken over by the next one
+ */
+#ifndef PROMISE_TRACE_BUFFER_SIZE
+# define PROMISE_TRACE_BUFFER_SIZE (1 << 20)
+#endif // PROMISE_TRACE_BUFFER_SIZE
+
+/*
+ * counts spins, yields and the time spent in the forward spin loops per forwarded type
+ *  read by `Promise2::Contention::snapshot`, nothing compiled in if 0
+ */
+#ifndef PROMISE_CONTENTION_STATS
+# define PROMISE_CONTENTION_STATS 0
+#endif // PROMISE_CONTENTION_STATS
+
+/*
+ * records the creation time and backtrace of every live node
+ *  `Promise2::Diagnostics::dumpLeaks` writes the ones alive past the threshold, debugging only
+ */
+#ifndef PROMISE_LEAK_DETECTOR
+# define PROMISE_LEAK_DETECTOR 0
+#endif // PROMISE_LEAK_DETECTOR
+
+/*
+ * counts the live nodes by kind and the values settled before chained
+ *  read by `Promise2::Diagnostics::liveNodes` and `unconsumedValues`, on along with the leak detector
+ */
+#ifndef PROMISE_LIVE_GAUGES
+# define PROMISE_LIVE_GAUGES PROMISE_LEAK_DETECTOR
+#endif // PROMISE_LIVE_GAUGES
+
+/*
+ * default age of the nodes reported as leaked
+ */
+#ifndef PROMISE_LEAK_THRESHOLD_MS
+# define PROMISE_LEAK_THRESHOLD_MS 10000
+#endif // PROMISE_LEAK_THRESHOLD_MS
+
+/*
+ * frames kept of each creation backtrace
+ */
+#ifndef PROMISE_LEAK_BACKTRACE_DEPTH
+# define PROMISE_LEAK_BACKTRACE_DEPTH 16
+#endif // PROMISE_LEAK_BACKTRACE_DEPTH
+
+/*
+ * `Promise::wait()` parks on the state word via `std::atomic::wait` (c++20)
+ *  otherwise on the shared parking lot buckets
+ */
+#ifndef USE_ATOMIC_WAIT
+# if __cplusplus >= 202002L
+#  define USE_ATOMIC_WAIT 1
+# else
+#  define USE_ATOMIC_WAIT 0
+# endif
+#endif // USE_ATOMIC_WAIT
+
+/*
+ * `co_await` a `Promise` and return `Promise` from coroutines (c++20)
+ */
+#ifndef USE_COROUTINE
+# if defined(__cpp_impl_coroutine)
+#  define USE_COROUTINE 1
+# else
+#  define USE_COROUTINE 0
+# endif
+#endif // USE_COROUTINE
 
 #endif // PROMISE_CONFIG_H
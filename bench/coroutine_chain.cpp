@@ -0,0 +1,77 @@
+/*
+ * Promise2
+ *
+ * Copyright (c) 2016 "0of" Magnus
+ * Licensed under the MIT license.
+ * https://github.com/0of/Promise2/blob/master/LICENSE
+ */
+
+//
+// sequential async steps written as a `then` chain and as a coroutine
+//
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "Promise.h"
+
+#if !USE_COROUTINE
+# error "coroutine support is required, please enable `USE_COROUTINE` in `PromiseConfig.h`"
+#endif // !USE_COROUTINE
+
+class CurrentContext : public Promise2::ThreadContext {
+public:
+  static ThreadContext *New() {
+    return new CurrentContext;
+  }
+
+public:
+  virtual void scheduleToRun(std::function<void()>&& task) override {
+    task();
+  }
+};
+
+namespace {
+  constexpr const std::int32_t Depth = 16;
+
+  Promise2::Promise<std::int32_t> thenChain() {
+    auto p = Promise2::Promise<std::int32_t>::Resolved(0);
+    for (std::int32_t i = 0; i < Depth; ++i) {
+      p = p.then([](std::int32_t v) { return v + 1; }, CurrentContext::New());
+    }
+
+    return p;
+  }
+
+  Promise2::Promise<std::int32_t> coroutineChain() {
+    std::int32_t v = 0;
+    for (std::int32_t i = 0; i < Depth; ++i) {
+      v = co_await Promise2::Promise<std::int32_t>::Resolved(v + 1);
+    }
+
+    co_return v;
+  }
+
+  template<typename Chain>
+  double measure(Chain&& chain, std::int32_t rounds) {
+    auto begin = std::chrono::steady_clock::now();
+
+    for (std::int32_t i = 0; i < rounds; ++i) {
+      if (Depth != chain().get()) {
+        std::abort();
+      }
+    }
+
+    auto elapsed = std::chrono::steady_clock::now() - begin;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / rounds;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  std::int32_t rounds = argc > 1 ? std::atoi(argv[1]) : 100000;
+
+  std::printf("{\"depth\": %d, \"rounds\": %d, \"then_chain_ns\": %.1f, \"coroutine_ns\": %.1f}\n",
+              Depth, rounds, measure(thenChain, rounds), measure(coroutineChain, rounds));
+  return 0;
+}
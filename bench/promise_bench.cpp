@@ -0,0 +1,193 @@
+/*
+ * Promise2
+ *
+ * Copyright (c) 2016 "0of" Magnus
+ * Licensed under the MIT license.
+ * https://github.com/0of/Promise2/blob/master/LICENSE
+ */
+
+//
+// spawn, `then` chains, the resolved fast path, recursion throughput and `caught`
+// measured against every shipped `ThreadContext`, printed as JSON
+//
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "Promise.h"
+#include "context/ThreadContext_STL.h"
+
+#if USE_DISPATCH
+# include "context/ThreadContext_GCD.h"
+#endif // USE_DISPATCH
+
+#ifdef _WIN32
+# include "context/ThreadContext_Windows.h"
+#endif // _WIN32
+
+class CurrentContext : public Promise2::ThreadContext {
+public:
+  static ThreadContext *New() {
+    return new CurrentContext;
+  }
+
+public:
+  virtual void scheduleToRun(std::function<void()>&& task) override {
+    task();
+  }
+};
+
+namespace {
+  constexpr const std::int32_t Depth = 16;
+  constexpr const std::int32_t ElementsPerRound = 64;
+
+  struct Context {
+    const char *name;
+    Promise2::ThreadContext *(*make)();
+    // rounds are divided by, a thread per task costs far more than running inline
+    std::int32_t slowdown;
+  };
+
+  const Context Contexts[] = {
+    { "inline", &CurrentContext::New, 1 },
+    { "stl_detached", &ThreadContextImpl::STL::DetachedThreadContext::New, 50 },
+    { "stl_thread_pool", [] {
+      static auto pool = ThreadContextImpl::STL::ThreadPool::New();
+      return ThreadContextImpl::STL::ThreadPoolContext::New(pool);
+    }, 10 },
+#if USE_DISPATCH
+    { "gcd_global_queue", [] { return ThreadContextImpl::GCD::QueueBasedThreadContext::New(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0)); }, 10 },
+#endif // USE_DISPATCH
+#ifdef _WIN32
+    { "windows_thread_pool", &ThreadContextImpl::Windows::ThreadPoolContext::New, 10 },
+#endif // _WIN32
+  };
+
+  class CountingIterator {
+  private:
+    std::int32_t _index;
+
+  public:
+    explicit CountingIterator(std::int32_t index) : _index{ index } {}
+
+  public:
+    bool operator != (const CountingIterator& i) { return i._index != _index; }
+
+    CountingIterator& operator++ () {
+      ++_index;
+      return *this;
+    }
+
+    std::int32_t operator *() const { return _index; }
+  };
+
+  void check(bool passed) {
+    // the measured work must not be optimized away or silently broken
+    if (!passed) std::abort();
+  }
+
+  template<typename Round>
+  double measure(std::int32_t rounds, Round&& round) {
+    auto begin = std::chrono::steady_clock::now();
+
+    for (std::int32_t i = 0; i < rounds; ++i) {
+      round();
+    }
+
+    auto elapsed = std::chrono::steady_clock::now() - begin;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / rounds;
+  }
+
+  bool first = true;
+
+  void report(const char *benchmark, const Context& context, std::int32_t rounds, std::int32_t opsPerRound, double nsPerRound) {
+    double nsPerOp = nsPerRound / opsPerRound;
+
+    std::printf("%s\n    {\"benchmark\": \"%s\", \"context\": \"%s\", \"rounds\": %d, \"ops_per_round\": %d, \"ns_per_op\": %.1f, \"ops_per_sec\": %.0f}",
+                first ? "" : ",", benchmark, context.name, rounds, opsPerRound, nsPerOp, 1e9 / nsPerOp);
+    std::fflush(stdout);
+    first = false;
+  }
+
+  void spawn(const Context& context, std::int32_t rounds) {
+    auto ns = measure(rounds, [&] {
+      check(1 == Promise2::Promise<std::int32_t>::New([] { return 1; }, context.make()).get());
+    });
+
+    report("spawn", context, rounds, 1, ns);
+  }
+
+  void thenChain(const Context& context, std::int32_t rounds) {
+    auto ns = measure(rounds, [&] {
+      auto p = Promise2::Promise<std::int32_t>::New([] { return 0; }, context.make());
+      for (std::int32_t i = 0; i < Depth; ++i) {
+        p = p.then([](std::int32_t v) { return v + 1; }, context.make());
+      }
+
+      check(Depth == p.get());
+    });
+
+    // latency of the whole chain
+    report("then_chain", context, rounds, 1, ns);
+  }
+
+  void resolvedThen(const Context& context, std::int32_t rounds) {
+    auto ns = measure(rounds, [&] {
+      check(2 == Promise2::Promise<std::int32_t>::Resolved(1).then([](std::int32_t v) { return v + 1; }, context.make()).get());
+    });
+
+    report("resolved_then", context, rounds, 1, ns);
+  }
+
+  void iterate(const Context& context, std::int32_t rounds) {
+    auto ns = measure(rounds, [&] {
+      std::atomic<std::int32_t> count{ 0 };
+
+      Promise2::RecursionPromise<std::int32_t>::Iterate(CountingIterator(0), CountingIterator(ElementsPerRound), context.make()).
+        then([&](std::int32_t ) { ++count; }, CurrentContext::New()).get();
+
+      check(ElementsPerRound == count);
+    });
+
+    report("iterate", context, rounds, ElementsPerRound, ns);
+  }
+
+  void caught(const Context& context, std::int32_t rounds) {
+    auto e = std::make_exception_ptr(std::runtime_error("bench"));
+
+    auto ns = measure(rounds, [&] {
+      bool handled = false;
+
+      auto p = Promise2::Promise<std::int32_t>::Rejected(e).caught([&](std::exception_ptr) { handled = true; }, context.make());
+      // the returned one is still rejected
+      p.wait();
+
+      check(handled && p.isRejected());
+    });
+
+    report("caught", context, rounds, 1, ns);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  std::int32_t rounds = argc > 1 ? std::atoi(argv[1]) : 100000;
+
+  std::printf("{\n  \"depth\": %d,\n  \"results\": [", Depth);
+
+  for (const auto& context : Contexts) {
+    auto contextRounds = std::max<std::int32_t>(rounds / context.slowdown, 1);
+
+    spawn(context, contextRounds);
+    thenChain(context, std::max<std::int32_t>(contextRounds / Depth, 1));
+    resolvedThen(context, contextRounds);
+    iterate(context, contextRounds);
+    caught(context, contextRounds);
+  }
+
+  std::printf("\n  ]\n}\n");
+  return 0;
+}
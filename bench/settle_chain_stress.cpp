@@ -0,0 +1,266 @@
+/*
+ * Promise2
+ *
+ * Copyright (c) 2016 "0of" Magnus
+ * Licensed under the MIT license.
+ * https://github.com/0of/Promise2/blob/master/LICENSE
+ */
+
+//
+// races `fulfill/reject` against `doChaining` on the same forwards from two threads while a third polls the status,
+// every pair is checked to be notified exactly once with its own value, printed as JSON
+// build with `-DBENCH_SANITIZER=thread` or `address` to run the handoff under the sanitizers
+//
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "Promise.h"
+
+namespace {
+  constexpr const std::int32_t Batch = 1024;
+
+  enum class Role : std::int32_t {
+    Main = 0,
+    Settler,
+    Chainer,
+    Observer
+  };
+
+  thread_local Role role = Role::Main;
+
+  // yields at seeded random items so the two sides interleave even on a single core
+  class Jitter {
+  private:
+    std::uint64_t _state;
+
+  public:
+    explicit Jitter(std::uint64_t seed) : _state{ seed | 1 } {}
+
+  public:
+    void operator()() {
+      _state ^= _state << 13;
+      _state ^= _state >> 7;
+      _state ^= _state << 17;
+
+      if (0 == (_state & 0xFF)) std::this_thread::yield();
+    }
+  };
+
+  void check(bool passed) {
+    // a lost, doubled or mismatched notification is the bug this harness hunts
+    if (!passed) std::abort();
+  }
+
+  struct Slot {
+    std::atomic<std::int32_t> notified;
+    std::int32_t value;
+    bool rejected;
+    // notified by the settler means chained first
+    Role notifiedBy;
+  };
+
+  struct Totals {
+    std::int64_t pairs = 0;
+    std::int64_t chainFirst = 0;
+    std::int64_t settleFirst = 0;
+    double nanoseconds = 0;
+  };
+
+  //
+  // @class Race
+  //  the three threads live across rounds, each round races a fresh batch of forwards
+  //
+  template<typename ForwardType>
+  class Race {
+  private:
+    std::vector<std::unique_ptr<ForwardType>> _forwards;
+    std::vector<Slot> _slots;
+
+    std::atomic<std::int64_t> _round;
+    std::atomic<std::int32_t> _finished;
+    std::atomic<bool> _stopped;
+
+    bool _reject;
+    std::exception_ptr _exception;
+
+    std::vector<std::thread> _threads;
+
+  public:
+    explicit Race(bool reject)
+      : _forwards(Batch)
+      , _slots(Batch)
+      , _round{ 0 }
+      , _finished{ 0 }
+      , _stopped{ false }
+      , _reject{ reject }
+      , _exception{ std::make_exception_ptr(std::runtime_error("stress")) } {
+      _threads.emplace_back([this] { loop(Role::Settler); });
+      _threads.emplace_back([this] { loop(Role::Chainer); });
+      _threads.emplace_back([this] { loop(Role::Observer); });
+    }
+
+    ~Race() {
+      _stopped = true;
+      for (auto& thread : _threads) thread.join();
+    }
+
+  public:
+    // one batch raced, returns the nanoseconds from release till every thread finished
+    double run(std::int64_t round, Totals& totals) {
+      for (std::int32_t i = 0; i < Batch; ++i) {
+        _forwards[i].reset(new ForwardType);
+        _slots[i].notified.store(0, std::memory_order_relaxed);
+        _slots[i].value = -1;
+        _slots[i].rejected = false;
+        _slots[i].notifiedBy = Role::Main;
+      }
+
+      _finished.store(0, std::memory_order_relaxed);
+
+      auto begin = std::chrono::steady_clock::now();
+      _round.store(round, std::memory_order_release);
+
+      while (_finished.load(std::memory_order_acquire) != 3) {
+        std::this_thread::yield();
+      }
+
+      auto elapsed = std::chrono::steady_clock::now() - begin;
+
+      for (std::int32_t i = 0; i < Batch; ++i) {
+        auto& slot = _slots[i];
+        check(1 == slot.notified.load(std::memory_order_relaxed));
+        check(_reject == slot.rejected);
+        check(_reject || i == slot.value);
+        check(_reject ? _forwards[i]->isRejected() : _forwards[i]->isFulfilled());
+        check(_forwards[i]->hasChained());
+
+        ++(Role::Settler == slot.notifiedBy ? totals.chainFirst : totals.settleFirst);
+      }
+
+      totals.pairs += Batch;
+      return std::chrono::duration<double, std::nano>(elapsed).count();
+    }
+
+  private:
+    void loop(Role threadRole) {
+      role = threadRole;
+      std::int64_t seen = 0;
+
+      while (true) {
+        std::int64_t round;
+        while ((round = _round.load(std::memory_order_acquire)) == seen) {
+          if (_stopped.load(std::memory_order_relaxed)) return;
+          std::this_thread::yield();
+        }
+
+        seen = round;
+
+        switch (threadRole) {
+          case Role::Settler: settleAll(Jitter{ static_cast<std::uint64_t>(round) * 2 }); break;
+          case Role::Chainer: chainAll(Jitter{ static_cast<std::uint64_t>(round) * 2 + 1 }, 0 == round % 2); break;
+          default: observeAll(); break;
+        }
+
+        _finished.fetch_add(1, std::memory_order_acq_rel);
+      }
+    }
+
+    void settleAll(Jitter&& jitter) {
+      for (std::int32_t i = 0; i < Batch; ++i) {
+        jitter();
+
+        if (_reject) {
+          _forwards[i]->reject(_exception);
+        } else {
+          _forwards[i]->fulfill(i);
+        }
+      }
+    }
+
+    // walked along with the settler to collide on the same forwards, or against it to meet halfway
+    void chainAll(Jitter&& jitter, bool along) {
+      for (std::int32_t n = 0; n < Batch; ++n) {
+        jitter();
+
+        auto i = along ? n : Batch - 1 - n;
+        auto slot = &_slots[i];
+
+        _forwards[i]->doChaining([slot](const auto& value) {
+          if (value->isExceptionCase()) {
+            slot->rejected = true;
+          } else {
+            slot->value = value->template getValue<std::int32_t>();
+          }
+
+          slot->notifiedBy = role;
+          slot->notified.fetch_add(1, std::memory_order_relaxed);
+        });
+      }
+    }
+
+    // the status is read from a thread neither settling nor chaining
+    void observeAll() {
+      std::int32_t settled = 0;
+
+      while (settled != Batch) {
+        settled = 0;
+        for (std::int32_t i = 0; i < Batch; ++i) {
+          if (_forwards[i]->isSettled()) ++settled;
+        }
+
+        std::this_thread::yield();
+      }
+    }
+  };
+
+  bool first = true;
+
+  void report(const char *scenario, const Totals& totals) {
+    double nsPerPair = totals.nanoseconds / totals.pairs;
+
+    std::printf("%s\n    {\"scenario\": \"%s\", \"pairs\": %lld, \"settle_first\": %lld, \"chain_first\": %lld, \"ns_per_pair\": %.1f, \"pairs_per_sec\": %.0f}",
+                first ? "" : ",", scenario, static_cast<long long>(totals.pairs), static_cast<long long>(totals.settleFirst),
+                static_cast<long long>(totals.chainFirst), nsPerPair, 1e9 / nsPerPair);
+    std::fflush(stdout);
+    first = false;
+  }
+
+  template<typename ForwardType>
+  void stress(const char *scenario, std::int64_t pairs, bool reject) {
+    Totals totals;
+
+    {
+      Race<ForwardType> race{ reject };
+
+      for (std::int64_t round = 1; totals.pairs < pairs; ++round) {
+        totals.nanoseconds += race.run(round, totals);
+      }
+    }
+
+    report(scenario, totals);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  std::int64_t pairs = argc > 1 ? std::atoll(argv[1]) : 1000000;
+
+  using SingleForward = Promise2::Details::Forward<std::int32_t, Promise2::Details::SingleValueForwardTrait>;
+  // the finish forward of the recursion promises
+  using MultiChainForward = Promise2::Details::MultiChainForward<std::int32_t, Promise2::Details::SingleValueForwardTrait>;
+
+  std::printf("{\n  \"threads\": 3,\n  \"batch\": %d,\n  \"results\": [", Batch);
+
+  stress<SingleForward>("fulfill_vs_chain", pairs, false);
+  stress<SingleForward>("reject_vs_chain", pairs, true);
+  stress<MultiChainForward>("multi_chain_fulfill_vs_chain", pairs, false);
+
+  std::printf("\n  ]\n}\n");
+  return 0;
+}
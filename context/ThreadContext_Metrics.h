@@ -0,0 +1,336 @@
+/*
+ * Promise2
+ *
+ * Copyright (c) 2016 "0of" Magnus
+ * Licensed under the MIT license.
+ * https://github.com/0of/Promise2/blob/master/LICENSE
+ */
+#ifndef THREAD_CONTEXT_METRICS_H
+#define THREAD_CONTEXT_METRICS_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "../public/PromisePublicAPIs.h"
+
+namespace ThreadContextImpl {
+  namespace Metrics {
+    namespace Details {
+      inline std::uint64_t now() {
+        auto elapsed = std::chrono::steady_clock::now().time_since_epoch();
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+      }
+
+      // single writer, readers may see the counter one behind
+      inline void increase(std::atomic<std::uint64_t>& counter, std::uint64_t by = 1) {
+        counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+      }
+    } // Details
+
+    //
+    // @class HistogramSnapshot
+    //  log-linear buckets in nanoseconds, each power of two split into `SubBuckets`
+    //  the relative error of a recorded value is within 1 / `SubBuckets`
+    //
+    class HistogramSnapshot {
+    public:
+      static constexpr const std::uint32_t SubBucketBits = 3;
+      static constexpr const std::uint32_t SubBuckets = 1 << SubBucketBits;
+      static constexpr const std::uint32_t BucketCount = (64 - SubBucketBits + 1) * SubBuckets;
+
+    public:
+      std::array<std::uint64_t, BucketCount> counts;
+      std::uint64_t count;
+
+    public:
+      HistogramSnapshot()
+        : counts{}
+        , count{ 0 }
+      {}
+
+    public:
+      static std::uint32_t indexOf(std::uint64_t value) {
+        if (value < SubBuckets) return static_cast<std::uint32_t>(value);
+
+        std::uint32_t magnitude = 63;
+        while (!(value >> magnitude)) --magnitude;
+
+        // the bits following the leading one select the sub bucket
+        auto shift = magnitude - SubBucketBits;
+        return (shift + 1) * SubBuckets + static_cast<std::uint32_t>((value >> shift) & (SubBuckets - 1));
+      }
+
+      // the smallest value falls into the bucket
+      static std::uint64_t lowerBoundOf(std::uint32_t index) {
+        if (index < SubBuckets) return index;
+
+        auto shift = index / SubBuckets - 1;
+        return (static_cast<std::uint64_t>(SubBuckets + index % SubBuckets)) << shift;
+      }
+
+    public:
+      // in nanoseconds, 0 if nothing recorded
+      std::uint64_t valueAtPercentile(double percentile) const {
+        if (0 == count) return 0;
+
+        auto rank = static_cast<std::uint64_t>(percentile / 100.0 * static_cast<double>(count) + 0.5);
+        if (rank < 1) rank = 1;
+
+        std::uint64_t seen = 0;
+        for (std::uint32_t i = 0; i < BucketCount; ++i) {
+          seen += counts[i];
+          if (seen >= rank) return lowerBoundOf(i);
+        }
+
+        return lowerBoundOf(BucketCount - 1);
+      }
+    };
+
+    struct MetricsSnapshot {
+      std::uint64_t enqueued;
+      std::uint64_t started;
+      std::uint64_t completed;
+
+      // scheduled but not started yet
+      std::uint64_t queueDepth;
+      // completed since the previous snapshot
+      double tasksPerSecond;
+
+      // enqueue to start
+      HistogramSnapshot waitTime;
+      HistogramSnapshot runTime;
+    };
+
+    //
+    // @class ContextMetrics
+    //  shared by every decorated context reporting to it
+    //  each thread records into its own shard, a shard left by an exited thread is taken over by the next one
+    //
+    class ContextMetrics {
+    private:
+      class Shard {
+      public:
+        std::atomic_bool owned;
+
+        std::atomic<std::uint64_t> enqueued;
+        std::atomic<std::uint64_t> started;
+        std::atomic<std::uint64_t> completed;
+
+        std::array<std::atomic<std::uint64_t>, HistogramSnapshot::BucketCount> waitTime;
+        std::array<std::atomic<std::uint64_t>, HistogramSnapshot::BucketCount> runTime;
+
+      public:
+        Shard()
+          : owned{ true }
+          , enqueued{ 0 }
+          , started{ 0 }
+          , completed{ 0 } {
+          for (auto& bucket : waitTime) bucket.store(0, std::memory_order_relaxed);
+          for (auto& bucket : runTime) bucket.store(0, std::memory_order_relaxed);
+        }
+      };
+
+      // shards of the current thread, given back when the thread exits
+      //  held weakly so the shards are freed along with their metrics
+      class ShardCache {
+      public:
+        struct Entry {
+          std::uint64_t id;
+          // valid as long as the metrics is
+          Shard *shard;
+          std::weak_ptr<Shard> owner;
+        };
+
+        std::vector<Entry> shards;
+
+      public:
+        ~ShardCache() {
+          for (auto& entry : shards) {
+            if (auto shard = entry.owner.lock()) shard->owned.store(false, std::memory_order_release);
+          }
+        }
+
+      public:
+        void prune() {
+          shards.erase(std::remove_if(shards.begin(), shards.end(), [](const Entry& entry) { return entry.owner.expired(); }), shards.end());
+        }
+      };
+
+    private:
+      // identifies the metrics in the thread caches, never reused
+      const std::uint64_t _id;
+
+      std::mutex _mutex;
+      std::vector<std::shared_ptr<Shard>> _shards;
+
+      std::uint64_t _lastCompleted;
+      std::uint64_t _lastSnapshotAt;
+
+    public:
+      static std::shared_ptr<ContextMetrics> New() {
+        return std::shared_ptr<ContextMetrics>(new ContextMetrics);
+      }
+
+    protected:
+      ContextMetrics()
+        : _id{ ++ids() }
+        , _shards{}
+        , _lastCompleted{ 0 }
+        , _lastSnapshotAt{ Details::now() }
+      {}
+
+    public:
+      void onEnqueued() {
+        Details::increase(local().enqueued);
+      }
+
+      void onStarted(std::uint64_t waited) {
+        auto& shard = local();
+        Details::increase(shard.started);
+        Details::increase(shard.waitTime[HistogramSnapshot::indexOf(waited)]);
+      }
+
+      void onCompleted(std::uint64_t ran) {
+        auto& shard = local();
+        Details::increase(shard.completed);
+        Details::increase(shard.runTime[HistogramSnapshot::indexOf(ran)]);
+      }
+
+      MetricsSnapshot snapshot() {
+        MetricsSnapshot snapshot{};
+
+        std::lock_guard<std::mutex> _{ _mutex };
+
+        for (auto& shard : _shards) {
+          snapshot.enqueued += shard->enqueued.load(std::memory_order_relaxed);
+          snapshot.started += shard->started.load(std::memory_order_relaxed);
+          snapshot.completed += shard->completed.load(std::memory_order_relaxed);
+
+          for (std::uint32_t i = 0; i < HistogramSnapshot::BucketCount; ++i) {
+            snapshot.waitTime.counts[i] += shard->waitTime[i].load(std::memory_order_relaxed);
+            snapshot.runTime.counts[i] += shard->runTime[i].load(std::memory_order_relaxed);
+          }
+        }
+
+        for (std::uint32_t i = 0; i < HistogramSnapshot::BucketCount; ++i) {
+          snapshot.waitTime.count += snapshot.waitTime.counts[i];
+          snapshot.runTime.count += snapshot.runTime.counts[i];
+        }
+
+        // shards read one after another, the sums may be off by the tasks in flight
+        snapshot.queueDepth = snapshot.enqueued > snapshot.started ? snapshot.enqueued - snapshot.started : 0;
+
+        auto at = Details::now();
+        if (at > _lastSnapshotAt && snapshot.completed >= _lastCompleted) {
+          snapshot.tasksPerSecond = static_cast<double>(snapshot.completed - _lastCompleted) * 1e9 / static_cast<double>(at - _lastSnapshotAt);
+        }
+
+        _lastCompleted = snapshot.completed;
+        _lastSnapshotAt = at;
+
+        return snapshot;
+      }
+
+    private:
+      static std::atomic<std::uint64_t>& ids() {
+        static std::atomic<std::uint64_t> ids{ 0 };
+        return ids;
+      }
+
+      Shard& local() {
+        static thread_local ShardCache cache;
+        static thread_local std::pair<std::uint64_t, Shard *> last{ 0, nullptr };
+
+        if (last.first == _id) return *last.second;
+
+        for (auto& entry : cache.shards) {
+          if (entry.id == _id) {
+            last = { _id, entry.shard };
+            return *last.second;
+          }
+        }
+
+        auto shard = takeShard();
+        cache.prune();
+        cache.shards.push_back({ _id, shard.get(), shard });
+
+        last = { _id, shard.get() };
+        return *last.second;
+      }
+
+      std::shared_ptr<Shard> takeShard() {
+        std::lock_guard<std::mutex> _{ _mutex };
+
+        for (auto& shard : _shards) {
+          bool owned = false;
+          if (shard->owned.compare_exchange_strong(owned, true, std::memory_order_acquire)) return shard;
+        }
+
+        // apart from the control block, which outlives it in the thread caches
+        _shards.push_back(std::shared_ptr<Shard>(new Shard));
+        return _shards.back();
+      }
+
+    private:
+      ContextMetrics(const ContextMetrics& ) = delete;
+      ContextMetrics& operator = (const ContextMetrics& ) = delete;
+    };
+
+    //
+    // @class MeasuredThreadContext
+    //  decorates any context, the tasks run by the wrapped one as they are
+    //
+    class MeasuredThreadContext : public Promise2::ThreadContext {
+    public:
+      static Promise2::ThreadContext *New(Promise2::ThreadContext* &&context, const std::shared_ptr<ContextMetrics>& metrics) {
+        return new MeasuredThreadContext{ std::move(context), metrics };
+      }
+
+    private:
+      std::unique_ptr<Promise2::ThreadContext> _context;
+      std::shared_ptr<ContextMetrics> _metrics;
+
+    protected:
+      MeasuredThreadContext(Promise2::ThreadContext* &&context, const std::shared_ptr<ContextMetrics>& metrics)
+        : _context{ context }
+        , _metrics{ metrics }
+      {}
+
+    public:
+      virtual ~MeasuredThreadContext() = default;
+
+    public:
+      virtual void scheduleToRun(std::function<void()>&& task) override {
+        auto enqueuedAt = Details::now();
+        _metrics->onEnqueued();
+
+        _context->scheduleToRun([metrics = _metrics, enqueuedAt, task = std::move(task)] {
+          auto startedAt = Details::now();
+          metrics->onStarted(startedAt - enqueuedAt);
+
+          // counted even if the task throws
+          struct Completion {
+            ContextMetrics *metrics;
+            std::uint64_t startedAt;
+            ~Completion() { metrics->onCompleted(Details::now() - startedAt); }
+          } completion{ metrics.get(), startedAt };
+
+          task();
+        });
+      }
+
+    private:
+      MeasuredThreadContext(const MeasuredThreadContext& ) = delete;
+      MeasuredThreadContext& operator = (const MeasuredThreadContext& ) = delete;
+    };
+  } // Metrics
+}
+
+#endif // THREAD_CONTEXT_METRICS_H
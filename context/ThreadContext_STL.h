@@ -8,7 +8,17 @@
 #ifndef THREAD_CONTEXT_STL_H
 #define THREAD_CONTEXT_STL_H
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include "../public/PromisePublicAPIs.h"
 
@@ -20,9 +30,6 @@ namespace ThreadContextImpl {
         return new DetachedThreadContext;
       }
 
-    private:
-      std::thread _detachedThread;
-
     protected:
       DetachedThreadContext() = default;
 
@@ -30,17 +37,320 @@ namespace ThreadContextImpl {
       virtual ~DetachedThreadContext() = default;
 
     public:
+      // may be called from several threads at the same time
       virtual void scheduleToRun(std::function<void()>&& task) override {
         std::thread taskThread{ std::move(task) };
-        _detachedThread = std::move(taskThread);
-
-        _detachedThread.detach();
+        taskThread.detach();
       }
 
     private:
       DetachedThreadContext(const DetachedThreadContext& ) = delete;
       DetachedThreadContext& operator = (const DetachedThreadContext& ) = delete;
     };
+
+    struct StalledTask {
+      std::thread::id thread;
+      // empty if the task is not labelled
+      std::string label;
+      std::chrono::nanoseconds running;
+    };
+
+    struct WatchdogOptions {
+      // zero disables the watchdog
+      std::chrono::nanoseconds threshold = std::chrono::seconds(1);
+      std::chrono::nanoseconds interval = std::chrono::milliseconds(100);
+
+      // spawns a worker for each stalled one so the queue keeps draining, retired once no task stalled
+      bool compensate = false;
+      std::size_t maxCompensatingWorkers = 4;
+
+      // called on the watchdog thread once per stalled task, reported to `std::cerr` if empty
+      std::function<void(const StalledTask&)> onStalled;
+    };
+
+    //
+    // @class ThreadPool
+    //  fixed workers sharing one queue, may be shared by several `ThreadPoolContext`
+    //  the watchdog reports the tasks running longer than the threshold along with their labels
+    //
+    class ThreadPool {
+    private:
+      struct Worker {
+        std::thread thread;
+        const bool compensating;
+
+        // steady clock nanoseconds the running task started at, 0 if idle
+        std::atomic<std::int64_t> startedAt;
+        // the label of the running task, owned by the worker thread
+        std::atomic<std::atomic<Promise2::Details::LabelStats *> *> label;
+
+        // watchdog only
+        std::int64_t reportedAt;
+        std::atomic_bool stalled;
+        std::atomic_bool exited;
+
+        explicit Worker(bool isCompensating)
+          : thread{}
+          , compensating{ isCompensating }
+          , startedAt{ 0 }
+          , label{ nullptr }
+          , reportedAt{ 0 }
+          , stalled{ false }
+          , exited{ false }
+        {}
+      };
+
+      // kept by the workers, so that the pool may be released by its own tasks
+      class Core : public std::enable_shared_from_this<Core> {
+      public:
+        const WatchdogOptions options;
+
+        std::mutex mutex;
+        std::condition_variable available;
+        std::deque<std::function<void()>> tasks;
+        std::vector<std::unique_ptr<Worker>> workers;
+        bool stopping;
+
+        std::atomic<std::size_t> stalled;
+        std::size_t compensating;
+
+        std::condition_variable watchdogWakeup;
+        std::thread watchdog;
+
+      public:
+        explicit Core(const WatchdogOptions& watchdogOptions)
+          : options{ watchdogOptions }
+          , stopping{ false }
+          , stalled{ 0 }
+          , compensating{ 0 }
+        {}
+
+      public:
+        // under the lock
+        void spawn(bool isCompensating) {
+          workers.emplace_back(new Worker{ isCompensating });
+
+          auto worker = workers.back().get();
+          worker->thread = std::thread{ [core = shared_from_this(), worker] { core->work(worker); } };
+
+          if (isCompensating) ++compensating;
+        }
+
+        void work(Worker *worker) {
+          worker->label.store(&Promise2::Details::currentLabel(), std::memory_order_release);
+
+          std::unique_lock<std::mutex> lock{ mutex };
+
+          while (true) {
+            // compensating ones retire once nothing stalled
+            if (worker->compensating && 0 == stalled.load(std::memory_order_relaxed)) break;
+
+            if (tasks.empty()) {
+              if (stopping) break;
+
+              if (worker->compensating) {
+                available.wait_for(lock, options.interval);
+              } else {
+                available.wait(lock);
+              }
+              continue;
+            }
+
+            auto task = std::move(tasks.front());
+            tasks.pop_front();
+
+            worker->startedAt.store(now(), std::memory_order_release);
+            lock.unlock();
+
+            task();
+            // may release the pool
+            task = nullptr;
+
+            lock.lock();
+
+            // cleared under the lock, otherwise the watchdog may mark it stalled right after
+            worker->startedAt.store(0, std::memory_order_release);
+            if (worker->stalled.exchange(false, std::memory_order_acq_rel)) {
+              --stalled;
+            }
+          }
+
+          if (worker->compensating) --compensating;
+
+          worker->label.store(nullptr, std::memory_order_release);
+          worker->exited.store(true, std::memory_order_release);
+        }
+
+        void watch() {
+          std::vector<StalledTask> reports;
+          std::unique_lock<std::mutex> lock{ mutex };
+
+          while (!stopping) {
+            watchdogWakeup.wait_for(lock, options.interval);
+
+            reap();
+
+            auto at = now();
+            for (auto& worker : workers) {
+              auto startedAt = worker->startedAt.load(std::memory_order_acquire);
+              if (0 == startedAt || worker->reportedAt == startedAt || at - startedAt < options.threshold.count()) continue;
+
+              // once per task
+              worker->reportedAt = startedAt;
+
+              StalledTask task{ worker->thread.get_id(), {}, std::chrono::nanoseconds(at - startedAt) };
+              if (auto label = worker->label.load(std::memory_order_acquire)) {
+                if (auto stats = label->load(std::memory_order_acquire)) task.label = stats->name;
+              }
+
+              if (!worker->stalled.exchange(true, std::memory_order_acq_rel)) {
+                ++stalled;
+              }
+
+              if (options.compensate && compensating < options.maxCompensatingWorkers && !stopping) {
+                spawn(true);
+              }
+
+              reports.push_back(std::move(task));
+            }
+
+            // the reporter may schedule onto the pool
+            if (!reports.empty()) {
+              lock.unlock();
+              for (const auto& task : reports) report(task);
+              reports.clear();
+              lock.lock();
+            }
+          }
+        }
+
+        // joins the retired compensating workers, under the lock
+        void reap() {
+          for (auto i = workers.begin(); i != workers.end();) {
+            if ((*i)->compensating && (*i)->exited.load(std::memory_order_acquire)) {
+              (*i)->thread.join();
+              i = workers.erase(i);
+            } else {
+              ++i;
+            }
+          }
+        }
+
+        void report(const StalledTask& task) {
+          if (options.onStalled) {
+            options.onStalled(task);
+            return;
+          }
+
+          std::cerr << "Promise2: task on thread " << task.thread << " running for "
+                    << std::chrono::duration_cast<std::chrono::milliseconds>(task.running).count() << "ms"
+                    << (task.label.empty() ? "" : " labelled ") << task.label << std::endl;
+        }
+      };
+
+    private:
+      std::shared_ptr<Core> _core;
+
+    public:
+      static std::shared_ptr<ThreadPool> New(std::size_t workers = std::thread::hardware_concurrency(), const WatchdogOptions& options = WatchdogOptions{}) {
+        return std::shared_ptr<ThreadPool>(new ThreadPool{ workers, options });
+      }
+
+    protected:
+      ThreadPool(std::size_t workers, const WatchdogOptions& options)
+        : _core{ std::make_shared<Core>(options) } {
+        std::lock_guard<std::mutex> _{ _core->mutex };
+
+        for (std::size_t i = 0; i < std::max<std::size_t>(workers, 1); ++i) {
+          _core->spawn(false);
+        }
+
+        if (options.threshold > std::chrono::nanoseconds::zero()) {
+          _core->watchdog = std::thread{ [core = _core] { core->watch(); } };
+        }
+      }
+
+    public:
+      // the queued tasks are run before the workers stop
+      //  released by its own task, that worker finishes on its own
+      virtual ~ThreadPool() {
+        {
+          std::lock_guard<std::mutex> _{ _core->mutex };
+          _core->stopping = true;
+        }
+
+        _core->available.notify_all();
+        _core->watchdogWakeup.notify_all();
+
+        if (_core->watchdog.joinable()) {
+          if (std::this_thread::get_id() == _core->watchdog.get_id()) {
+            _core->watchdog.detach();
+          } else {
+            _core->watchdog.join();
+          }
+        }
+
+        // no more spawned once the watchdog stopped
+        for (auto& worker : _core->workers) {
+          if (std::this_thread::get_id() == worker->thread.get_id()) {
+            worker->thread.detach();
+          } else {
+            worker->thread.join();
+          }
+        }
+      }
+
+    public:
+      void schedule(std::function<void()>&& task) {
+        {
+          std::lock_guard<std::mutex> _{ _core->mutex };
+          _core->tasks.push_back(std::move(task));
+        }
+
+        _core->available.notify_one();
+      }
+
+      // stalled tasks still running
+      std::size_t stalled() const {
+        return _core->stalled.load(std::memory_order_relaxed);
+      }
+
+    private:
+      static std::int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+      }
+
+    private:
+      ThreadPool(const ThreadPool& ) = delete;
+      ThreadPool& operator = (const ThreadPool& ) = delete;
+    };
+
+    class ThreadPoolContext : public Promise2::ThreadContext {
+    public:
+      static Promise2::ThreadContext *New(const std::shared_ptr<ThreadPool>& pool) {
+        return new ThreadPoolContext{ pool };
+      }
+
+    private:
+      std::shared_ptr<ThreadPool> _pool;
+
+    protected:
+      explicit ThreadPoolContext(const std::shared_ptr<ThreadPool>& pool)
+        : _pool{ pool }
+      {}
+
+    public:
+      virtual ~ThreadPoolContext() = default;
+
+    public:
+      virtual void scheduleToRun(std::function<void()>&& task) override {
+        _pool->schedule(std::move(task));
+      }
+
+    private:
+      ThreadPoolContext(const ThreadPoolContext& ) = delete;
+      ThreadPoolContext& operator = (const ThreadPoolContext& ) = delete;
+    };
   } // STL
 } 
 
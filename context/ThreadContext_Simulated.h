@@ -0,0 +1,186 @@
+/*
+ * Promise2
+ *
+ * Copyright (c) 2016 "0of" Magnus
+ * Licensed under the MIT license.
+ * https://github.com/0of/Promise2/blob/master/LICENSE
+ */
+#ifndef THREAD_CONTEXT_SIMULATED_H
+#define THREAD_CONTEXT_SIMULATED_H
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "../public/PromisePublicAPIs.h"
+
+namespace ThreadContextImpl {
+  namespace Simulated {
+    //
+    // @class Simulation
+    //  virtual clock and the tasks scheduled onto it, nothing runs till driven
+    //  the tasks due at the same time run in an order picked by the seed
+    //  the same seed gives the same order with the same standard library
+    //  scheduling may come from any thread, driving from one thread at a time
+    //
+    class Simulation {
+    public:
+      using Duration = std::chrono::nanoseconds;
+
+    private:
+      std::mutex _mutex;
+
+      Duration _now;
+      // due time to the tasks, in scheduled order
+      std::map<Duration, std::vector<std::function<void()>>> _tasks;
+
+      std::mt19937_64 _interleaving;
+
+      std::uint64_t _scheduled;
+      std::uint64_t _ran;
+
+    public:
+      static std::shared_ptr<Simulation> New(std::uint64_t seed = 0) {
+        return std::shared_ptr<Simulation>(new Simulation{ seed });
+      }
+
+    protected:
+      explicit Simulation(std::uint64_t seed)
+        : _now{ 0 }
+        , _tasks{}
+        , _interleaving{ seed }
+        , _scheduled{ 0 }
+        , _ran{ 0 }
+      {}
+
+    public:
+      void schedule(std::function<void()>&& task, Duration delay) {
+        std::lock_guard<std::mutex> _{ _mutex };
+
+        _tasks[_now + delay].push_back(std::move(task));
+        ++_scheduled;
+      }
+
+      // runs the tasks due by now including the ones they schedule, the clock stays
+      //  returns the number of tasks ran
+      std::uint64_t runUntilIdle() {
+        std::uint64_t ran = 0;
+        while (runOne()) ++ran;
+
+        return ran;
+      }
+
+      // moves the clock forward, running every task due on the way at its due time
+      std::uint64_t advance(Duration duration) {
+        std::uint64_t ran = 0;
+
+        Duration until;
+        {
+          std::lock_guard<std::mutex> _{ _mutex };
+          until = _now + duration;
+        }
+
+        while (true) {
+          ran += runUntilIdle();
+
+          std::lock_guard<std::mutex> _{ _mutex };
+
+          if (_tasks.empty() || _tasks.begin()->first > until) {
+            _now = until;
+            break;
+          }
+
+          _now = _tasks.begin()->first;
+        }
+
+        return ran;
+      }
+
+      Duration now() {
+        std::lock_guard<std::mutex> _{ _mutex };
+        return _now;
+      }
+
+      // not ran yet, due or not
+      std::uint64_t pending() {
+        std::lock_guard<std::mutex> _{ _mutex };
+        return _scheduled - _ran;
+      }
+
+      std::uint64_t scheduled() {
+        std::lock_guard<std::mutex> _{ _mutex };
+        return _scheduled;
+      }
+
+    private:
+      bool runOne() {
+        std::function<void()> task;
+
+        {
+          std::lock_guard<std::mutex> _{ _mutex };
+
+          auto due = _tasks.begin();
+          if (_tasks.end() == due || due->first > _now) return false;
+
+          auto& tasks = due->second;
+
+          // the seeded pick among the ones due together
+          auto picked = std::uniform_int_distribution<std::size_t>{ 0, tasks.size() - 1 }(_interleaving);
+          task = std::move(tasks[picked]);
+          tasks.erase(tasks.begin() + picked);
+
+          if (tasks.empty()) _tasks.erase(due);
+
+          ++_ran;
+        }
+
+        task();
+        return true;
+      }
+
+    private:
+      Simulation(const Simulation& ) = delete;
+      Simulation& operator = (const Simulation& ) = delete;
+    };
+
+    //
+    // @class SimulatedContext
+    //  queues the tasks onto the simulation, `delay` after the time scheduled
+    //
+    class SimulatedContext : public Promise2::ThreadContext {
+    public:
+      static Promise2::ThreadContext *New(const std::shared_ptr<Simulation>& simulation, Simulation::Duration delay = Simulation::Duration::zero()) {
+        return new SimulatedContext{ simulation, delay };
+      }
+
+    private:
+      std::shared_ptr<Simulation> _simulation;
+      const Simulation::Duration _delay;
+
+    protected:
+      SimulatedContext(const std::shared_ptr<Simulation>& simulation, Simulation::Duration delay)
+        : _simulation{ simulation }
+        , _delay{ delay }
+      {}
+
+    public:
+      virtual ~SimulatedContext() = default;
+
+    public:
+      virtual void scheduleToRun(std::function<void()>&& task) override {
+        _simulation->schedule(std::move(task), _delay);
+      }
+
+    private:
+      SimulatedContext(const SimulatedContext& ) = delete;
+      SimulatedContext& operator = (const SimulatedContext& ) = delete;
+    };
+  } // Simulated
+}
+
+#endif // THREAD_CONTEXT_SIMULATED_H
@@ -0,0 +1,236 @@
+/*
+ * Promise2
+ *
+ * Copyright (c) 2016 "0of" Magnus
+ * Licensed under the MIT license.
+ * https://github.com/0of/Promise2/blob/master/LICENSE
+ */
+#ifndef BOUNDED_RECURSION_PROMISE_INTERNALS_H
+#define BOUNDED_RECURSION_PROMISE_INTERNALS_H
+
+#include <algorithm>
+#include <mutex>
+
+#include "../public/PromisePublicAPIs.h"
+#include "PromiseInternalsBase.h"
+
+namespace Promise2 {
+  namespace Details {
+
+    //
+    // @class Backpressure
+    //  counts the values produced but not yet consumed by the downstream
+    //  a paused producer is kept alive only once chained, nothing would release it otherwise
+    //
+    class Backpressure {
+    private:
+      std::atomic<std::size_t> _backlog;
+      std::atomic_bool _paused;
+
+      const std::size_t _highWaterMark;
+      const std::size_t _lowWaterMark;
+
+      // guards the paused producer, taken only when pausing, resuming or chaining
+      std::mutex _mutex;
+      bool _chained;
+      // paused once chained
+      std::shared_ptr<void> _producer;
+      // paused before chained, freed along with the last handle
+      std::weak_ptr<void> _unchainedProducer;
+
+      // reschedule the paused producer
+      std::function<void(const std::shared_ptr<void>&)> _resume;
+
+    public:
+      Backpressure(std::size_t highWaterMark, std::function<void(const std::shared_ptr<void>&)>&& resume)
+        : _backlog{ 0 }
+        , _paused{ false }
+        , _highWaterMark{ std::max<std::size_t>(highWaterMark, 1) }
+        , _lowWaterMark{ _highWaterMark / 2 }
+        , _chained{ false }
+        , _producer{}
+        , _unchainedProducer{}
+        , _resume{ std::move(resume) }
+      {}
+
+    public:
+      // false means the producer is paused till resumed
+      bool tryAcquire(const std::shared_ptr<void>& producer) {
+        if (_backlog.load() < _highWaterMark) {
+          ++_backlog;
+          return true;
+        }
+
+        {
+          std::lock_guard<std::mutex> _{ _mutex };
+          if (_chained) {
+            _producer = producer;
+          } else {
+            _unchainedProducer = producer;
+          }
+        }
+
+        _paused.store(true);
+
+        // the downstream may have drained before the flag published
+        if (_backlog.load() <= _lowWaterMark && _paused.exchange(false)) {
+          takeProducer();
+
+          ++_backlog;
+          return true;
+        }
+
+        return false;
+      }
+
+      void release() {
+        if (--_backlog <= _lowWaterMark && _paused.exchange(false)) {
+          if (auto producer = takeProducer()) {
+            _resume(producer);
+          }
+        }
+      }
+
+      // before the buffered values are flushed, the chaining one still holds the producer
+      void chained() {
+        std::lock_guard<std::mutex> _{ _mutex };
+
+        _chained = true;
+        _producer = _unchainedProducer.lock();
+        _unchainedProducer.reset();
+      }
+
+    private:
+      std::shared_ptr<void> takeProducer() {
+        std::lock_guard<std::mutex> _{ _mutex };
+
+        auto producer = _producer ? std::move(_producer) : _unchainedProducer.lock();
+        _unchainedProducer.reset();
+
+        return producer;
+      }
+    };
+
+    //
+    // @class BoundedForward
+    //  every value handed to the downstream is released back when the downstream drops it
+    //
+    template<typename ForwardType>
+    class BoundedForward : public Forward<ForwardType, MultiValueForwardTrait> {
+      using Base = Forward<ForwardType, MultiValueForwardTrait>;
+
+    private:
+      class Token {
+      public:
+        SharedPromiseValue<ForwardType> value;
+        std::shared_ptr<Backpressure> backpressure;
+
+      public:
+        Token(const SharedPromiseValue<ForwardType>& v, const std::shared_ptr<Backpressure>& b)
+          : value{ v }
+          , backpressure{ b }
+        {}
+
+        ~Token() {
+          backpressure->release();
+        }
+      };
+
+    private:
+      std::shared_ptr<Backpressure> _backpressure;
+
+    public:
+      explicit BoundedForward(const std::shared_ptr<Backpressure>& backpressure)
+        : Base()
+        , _backpressure{ backpressure }
+      {}
+
+    public:
+      virtual void doChaining(const DeferPromiseCore<ForwardType>& nextForward) override {
+        _backpressure->chained();
+        Base::doChaining(track(this->getDeferForwardNotify(nextForward)));
+      }
+
+      virtual void doChaining(std::function<void(const SharedPromiseValue<ForwardType>&)>&& notify) override {
+        _backpressure->chained();
+        Base::doChaining(track(std::move(notify)));
+      }
+
+    private:
+      // the notified value shares the ownership with the token
+      std::function<void(const SharedPromiseValue<ForwardType>&)> track(std::function<void(const SharedPromiseValue<ForwardType>&)>&& notify) {
+        return [backpressure = _backpressure, notify = std::move(notify)](const SharedPromiseValue<ForwardType>& v) {
+          auto token = std::make_shared<Token>(v, backpressure);
+          notify(SharedPromiseValue<ForwardType>{ token, v.get() });
+        };
+      }
+    };
+
+    //
+    // bounded recursion
+    //  the iteration suspends at the high-water mark and reschedules itself at the low-water mark
+    //
+    template<typename ReturnType, typename InputIterator>
+    class BoundedRecursionPromiseNodeInternal : public RecursionPromiseNodeInternalBase<ReturnType, Void, std::true_type> {
+      using Base = RecursionPromiseNodeInternalBase<ReturnType, Void, std::true_type>;
+      using SelfType = BoundedRecursionPromiseNodeInternal<ReturnType, InputIterator>;
+
+    private:
+      InputIterator _iter;
+      InputIterator _end;
+      std::shared_ptr<Backpressure> _backpressure;
+
+    public:
+      BoundedRecursionPromiseNodeInternal(const InputIterator& begin,
+                                          const InputIterator& end,
+                                          std::size_t highWaterMark,
+                                          OnRecursionRejectFunction<ReturnType>&& onReject,
+                                          const std::shared_ptr<ThreadContext>& context)
+        : BoundedRecursionPromiseNodeInternal(begin, end, std::make_shared<Backpressure>(highWaterMark, &SelfType::resume), std::move(onReject), context)
+      {}
+
+    private:
+      // the forward is built on the backpressure before the base
+      BoundedRecursionPromiseNodeInternal(const InputIterator& begin,
+                                          const InputIterator& end,
+                                          const std::shared_ptr<Backpressure>& backpressure,
+                                          OnRecursionRejectFunction<ReturnType>&& onReject,
+                                          const std::shared_ptr<ThreadContext>& context)
+        : Base(std::move(onReject), context, std::make_shared<BoundedForward<ReturnType>>(backpressure))
+        , _iter{ begin }
+        , _end{ end }
+        , _backpressure{ backpressure }
+      {}
+
+    public:
+      // run within the context
+      static void iterate(const std::shared_ptr<SelfType>& node) {
+        try {
+          for (; node->_iter != node->_end && !node->isHalted(); ++node->_iter) {
+            if (!node->_backpressure->tryAcquire(node)) {
+              // paused, `_iter` is kept for resuming
+              return;
+            }
+
+            node->_forward->fulfill(*node->_iter);
+          }
+        } catch (...) {
+          node->_finishForward->reject(std::current_exception());
+          return;
+        }
+
+        node->_finishForward->fulfill(Void{});
+      }
+
+    private:
+      static void resume(const std::shared_ptr<void>& producer) {
+        auto node = std::static_pointer_cast<SelfType>(producer);
+
+        auto runnable = std::bind(&SelfType::iterate, node);
+        node->_context->scheduleToRun(std::move(runnable));
+      }
+    };
+  } // Details
+}
+
+#endif // BOUNDED_RECURSION_PROMISE_INTERNALS_H
@@ -0,0 +1,200 @@
+/*
+ * Promise2
+ *
+ * Copyright (c) 2016 "0of" Magnus
+ * Licensed under the MIT license.
+ * https://github.com/0of/Promise2/blob/master/LICENSE
+ */
+#ifndef COROUTINE_PROMISE_INTERNALS_H
+#define COROUTINE_PROMISE_INTERNALS_H
+
+#include "../PromiseConfig.h"
+
+#if USE_COROUTINE
+
+#include <coroutine>
+
+#include "../public/PromisePublicAPIs.h"
+#include "PromiseInternalsBase.h"
+
+namespace Promise2 {
+  namespace Details {
+
+    enum class AwaitStatus : std::uint16_t {
+      Chaining = 0,
+      Suspended = 1,
+      Settled = 2
+    };
+
+    //
+    // @class PromiseAwaiter
+    //  chains the awaited promise and resumes the coroutine once settled
+    //
+    template<typename T>
+    class PromiseAwaiter {
+    private:
+      SharedPromiseNode<T> _node;
+      // null means resuming inline
+      std::shared_ptr<ThreadContext> _context;
+      SharedPromiseValue<BoxVoid<T>> _value;
+      std::atomic<AwaitStatus> _status;
+
+    public:
+      PromiseAwaiter(const SharedPromiseNode<T>& node, const std::shared_ptr<ThreadContext>& context)
+        : _node{ node }
+        , _context{ context }
+        , _value{}
+        , _status{ AwaitStatus::Chaining }
+      {}
+
+      PromiseAwaiter(PromiseAwaiter&& awaiter)
+        : _node{ std::move(awaiter._node) }
+        , _context{ std::move(awaiter._context) }
+        , _value{}
+        , _status{ AwaitStatus::Chaining }
+      {}
+
+    public:
+      bool await_ready() const noexcept {
+        return false;
+      }
+
+      std::coroutine_handle<> await_suspend(std::coroutine_handle<> handle) {
+        if (!_node) throw std::logic_error("invalid promise");
+
+        _node->chainNext([this, handle](const SharedPromiseValue<BoxVoid<T>>& v) {
+          _value = v;
+
+          // the awaiting side has already suspended
+          if (AwaitStatus::Suspended == _status.exchange(AwaitStatus::Settled)) {
+            resume(handle);
+          }
+        });
+
+        if (AwaitStatus::Settled == _status.exchange(AwaitStatus::Suspended)) {
+          // settled while chaining, transfer back to the coroutine directly
+          if (!_context) return handle;
+
+          resume(handle);
+        }
+
+        return std::noop_coroutine();
+      }
+
+      T await_resume() {
+        _value->accessGuard();
+        return static_cast<T>(_value->template getValue<BoxVoid<T>>());
+      }
+
+    private:
+      void resume(std::coroutine_handle<> handle) {
+        if (_context) {
+          // the frame as well as the awaiter may be gone when `scheduleToRun` returns
+          auto context = _context;
+          context->scheduleToRun([handle] { handle.resume(); });
+        } else {
+          handle.resume();
+        }
+      }
+
+    private:
+      PromiseAwaiter(const PromiseAwaiter&) = delete;
+      PromiseAwaiter& operator = (const PromiseAwaiter&) = delete;
+    };
+
+    //
+    // coroutine PromiseNodeInternal
+    //  the coroutine frame runs the body, the node only forwards the result
+    //
+    template<typename T>
+    class CoroutinePromiseNodeInternal : public PromiseNodeInternalBase<BoxVoid<T>, Void, std::true_type> {
+      using Base = PromiseNodeInternalBase<BoxVoid<T>, Void, std::true_type>;
+
+    public:
+      CoroutinePromiseNodeInternal()
+        : Base(OnRejectFunction<BoxVoid<T>>{}, nullptr)
+      {}
+
+    public:
+      const DeferPromiseCore<T>& forward() const {
+        return Base::_forward;
+      }
+    };
+
+    template<typename T>
+    class CoroutinePromiseTypeBase {
+    protected:
+      std::shared_ptr<CoroutinePromiseNodeInternal<T>> _node;
+
+    public:
+      CoroutinePromiseTypeBase()
+        : _node{ std::make_shared<CoroutinePromiseNodeInternal<T>>() }
+      {}
+
+    public:
+      // run eagerly till the first suspension
+      std::suspend_never initial_suspend() const noexcept { return {}; }
+      // the frame is destroyed as soon as the body returned
+      std::suspend_never final_suspend() const noexcept { return {}; }
+
+      void unhandled_exception() {
+        _node->forward()->reject(std::current_exception());
+      }
+    };
+
+    //
+    // @class CoroutinePromiseType
+    //  `promise_type` of the coroutines returning `Promise<T>`
+    //
+    template<typename T>
+    class CoroutinePromiseType : public CoroutinePromiseTypeBase<T> {
+      using Base = CoroutinePromiseTypeBase<T>;
+
+    public:
+      Promise<T> get_return_object() {
+        Promise<T> promise;
+        promise._node = Base::_node;
+
+        return promise;
+      }
+
+      template<typename ValueType>
+      void return_value(ValueType&& v) {
+        Base::_node->forward()->fulfill(std::forward<ValueType>(v));
+      }
+    };
+
+    template<>
+    class CoroutinePromiseType<void> : public CoroutinePromiseTypeBase<void> {
+      using Base = CoroutinePromiseTypeBase<void>;
+
+    public:
+      Promise<void> get_return_object() {
+        Promise<void> promise;
+        promise._node = Base::_node;
+
+        return promise;
+      }
+
+      void return_void() {
+        Base::_node->forward()->fulfill(Void{});
+      }
+    };
+  } // Details
+
+  template<typename T>
+  Details::PromiseAwaiter<T> operator co_await(const Promise<T>& promise) {
+    return Details::PromiseAwaiter<T>{ promise.internal(), nullptr };
+  }
+} // Promise2
+
+namespace std {
+  template<typename T, typename... Args>
+  struct coroutine_traits<Promise2::Promise<T>, Args...> {
+    using promise_type = Promise2::Details::CoroutinePromiseType<T>;
+  };
+}
+
+#endif // USE_COROUTINE
+
+#endif // COROUTINE_PROMISE_INTERNALS_H
@@ -61,7 +61,7 @@ namespace Promise2 {
       DeferredPromiseNodeInternal(std::function<Void(Defer&&, ConvertibleArgType)>&& onFulfill,
                   OnRejectFunction<ReturnType>&& onReject,
                   const std::shared_ptr<ThreadContext>& context)
-        : Base(std::move(onReject), context)
+        : Base(std::move(onReject), context, NodeKind::Deferred)
         , _onFulfill{ std::move(onFulfill) }
       {}
 
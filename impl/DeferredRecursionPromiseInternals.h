@@ -0,0 +1,264 @@
+/*
+ * Promise2
+ *
+ * Copyright (c) 2016 "0of" Magnus
+ * Licensed under the MIT license.
+ * https://github.com/0of/Promise2/blob/master/LICENSE
+ */
+#ifndef DEFERRED_RECURSION_PROMISE_INTERNALS_H
+#define DEFERRED_RECURSION_PROMISE_INTERNALS_H
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include "../public/PromisePublicAPIs.h"
+#include "PromiseInternalsBase.h"
+
+namespace Promise2 {
+  namespace Details {
+
+    //
+    // @class MPSCQueue
+    //  intrusive multi-producer single-consumer queue, producers only exchange the head
+    //  the node last popped stays as the stub
+    //
+    template<typename T>
+    class MPSCQueue {
+    public:
+      class Link {
+      public:
+        std::atomic<Link *> next;
+
+      public:
+        Link() : next{ nullptr } {}
+        virtual ~Link() = default;
+      };
+
+    private:
+      std::atomic<Link *> _head;
+      // consumer only
+      Link *_tail;
+
+    public:
+      MPSCQueue()
+        : _head{ nullptr }
+        , _tail{ new Link } {
+        _head.store(_tail);
+      }
+
+      ~MPSCQueue() {
+        while (_tail) {
+          auto next = _tail->next.load();
+          delete _tail;
+          _tail = next;
+        }
+      }
+
+    public:
+      // wait-free for producers
+      void push(Link *link) {
+        link->next.store(nullptr, std::memory_order_relaxed);
+        auto prev = _head.exchange(link, std::memory_order_acq_rel);
+        prev->next.store(link, std::memory_order_release);
+      }
+
+      // consumer only, the returned link is owned by the queue till the next pop
+      //  null if empty or a producer is in the middle of pushing
+      T *pop() {
+        auto next = _tail->next.load(std::memory_order_acquire);
+        if (!next) return nullptr;
+
+        delete _tail;
+        _tail = next;
+
+        return static_cast<T *>(next);
+      }
+
+    private:
+      MPSCQueue(const MPSCQueue&) = delete;
+      MPSCQueue& operator = (const MPSCQueue&) = delete;
+    };
+
+    template<typename ReturnType>
+    class DeferredRecursionEntry : public MPSCQueue<DeferredRecursionEntry<ReturnType>>::Link {
+    public:
+      enum class Kind : std::uint8_t {
+        Value = 0,
+        Finished = 1,
+        Failed = 2
+      };
+
+    public:
+      const Kind kind;
+      std::exception_ptr exception;
+
+    protected:
+      explicit DeferredRecursionEntry(Kind k)
+        : kind{ k }
+        , exception{}
+      {}
+
+    public:
+      static DeferredRecursionEntry *finished() {
+        return new DeferredRecursionEntry{ Kind::Finished };
+      }
+
+      static DeferredRecursionEntry *failed(std::exception_ptr e) {
+        auto entry = new DeferredRecursionEntry{ Kind::Failed };
+        entry->exception = e;
+        return entry;
+      }
+    };
+
+    template<typename ReturnType>
+    class DeferredRecursionValueEntry : public DeferredRecursionEntry<ReturnType> {
+      using Base = DeferredRecursionEntry<ReturnType>;
+
+    public:
+      ReturnType value;
+
+    public:
+      template<typename ValueType>
+      explicit DeferredRecursionValueEntry(ValueType&& v)
+        : Base{ Base::Kind::Value }
+        , value(std::forward<ValueType>(v))
+      {}
+    };
+
+    //
+    // deferred recursion PromiseNodeInternal
+    //  values pushed by any thread are queued and forwarded by one draining task at a time within the context
+    //
+    template<typename ReturnType>
+    class DeferredRecursionPromiseNodeInternal : public RecursionPromiseNodeInternalBase<ReturnType, Void, std::true_type> {
+      using Base = RecursionPromiseNodeInternalBase<ReturnType, Void, std::true_type>;
+      using SelfType = DeferredRecursionPromiseNodeInternal<ReturnType>;
+      using Entry = DeferredRecursionEntry<ReturnType>;
+      using ValueEntry = DeferredRecursionValueEntry<ReturnType>;
+
+    private:
+      MPSCQueue<Entry> _queue;
+      // entries queued but not forwarded yet, the producer raising it from zero schedules the draining task
+      std::atomic<std::uint32_t> _pending;
+      // `finish` or `fail` has been pushed
+      std::atomic_bool _closed;
+      // consumer only
+      bool _settled;
+
+    public:
+      explicit DeferredRecursionPromiseNodeInternal(const std::shared_ptr<ThreadContext>& context)
+        : Base(OnRecursionRejectFunction<ReturnType>{}, context)
+        , _queue{}
+        , _pending{ 0 }
+        , _closed{ false }
+        , _settled{ false }
+      {}
+
+    public:
+      template<typename ValueType>
+      static void push(const std::shared_ptr<SelfType>& node, ValueType&& v) {
+        if (node->_closed.load()) {
+          throw std::logic_error("recursion promise already finished");
+        }
+
+        enqueue(node, new ValueEntry{ std::forward<ValueType>(v) });
+      }
+
+      static void close(const std::shared_ptr<SelfType>& node, Entry *entry) {
+        if (node->_closed.exchange(true)) {
+          delete entry;
+          throw std::logic_error("recursion promise already finished");
+        }
+
+        enqueue(node, entry);
+      }
+
+    private:
+      static void enqueue(const std::shared_ptr<SelfType>& node, Entry *entry) {
+        node->_queue.push(entry);
+
+        if (0 == node->_pending.fetch_add(1, std::memory_order_acq_rel)) {
+          auto runnable = std::bind(&SelfType::drain, node);
+          node->_context->scheduleToRun(std::move(runnable));
+        }
+      }
+
+      // the queue is only touched while the pending count is non-zero, the next drain takes over once it drops to zero
+      static void drain(const std::shared_ptr<SelfType>& node) {
+        auto pending = node->_pending.load(std::memory_order_acquire);
+
+        while (0 != pending) {
+          for (std::uint32_t forwarded = 0; forwarded < pending; ) {
+            auto entry = node->_queue.pop();
+            if (!entry) {
+              // a producer has not linked its entry yet
+              std::this_thread::yield();
+              continue;
+            }
+
+            node->forward(*entry);
+            ++forwarded;
+          }
+
+          // counted meanwhile without scheduling another drain
+          pending = node->_pending.fetch_sub(pending, std::memory_order_acq_rel) - pending;
+        }
+      }
+
+      void forward(Entry& entry) noexcept {
+        // values pushed concurrently with `finish` may be queued behind it
+        if (_settled) return;
+
+        switch (entry.kind) {
+        case Entry::Kind::Value:
+          // discarded till finished once halted
+          if (Base::isHalted()) break;
+
+          try {
+            Base::_forward->fulfill(std::move(static_cast<ValueEntry&>(entry).value));
+          } catch (...) {
+            Base::_forward->reject(std::current_exception());
+          }
+          break;
+
+        case Entry::Kind::Finished:
+          _settled = true;
+          Base::_finishForward->fulfill(Void{});
+          break;
+
+        case Entry::Kind::Failed:
+          _settled = true;
+          Base::_finishForward->reject(entry.exception);
+          break;
+        }
+      }
+    };
+  } // Details
+
+  //
+  // @class RecursionPromiseDefer
+  //
+  template<typename T>
+  RecursionPromiseDefer<T>::RecursionPromiseDefer(const std::shared_ptr<Details::DeferredRecursionPromiseNodeInternal<BoxVoid<T>>>& node)
+    : _node{ node }
+  {}
+
+  template<typename T>
+  template<typename X>
+  void RecursionPromiseDefer<T>::push(X&& v) {
+    Details::DeferredRecursionPromiseNodeInternal<BoxVoid<T>>::push(_node, std::forward<X>(v));
+  }
+
+  template<typename T>
+  void RecursionPromiseDefer<T>::fail(std::exception_ptr e) {
+    Details::DeferredRecursionPromiseNodeInternal<BoxVoid<T>>::close(_node, Details::DeferredRecursionEntry<BoxVoid<T>>::failed(e));
+  }
+
+  template<typename T>
+  void RecursionPromiseDefer<T>::finish() {
+    Details::DeferredRecursionPromiseNodeInternal<BoxVoid<T>>::close(_node, Details::DeferredRecursionEntry<BoxVoid<T>>::finished());
+  }
+}
+
+#endif // DEFERRED_RECURSION_PROMISE_INTERNALS_H
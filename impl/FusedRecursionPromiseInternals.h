@@ -0,0 +1,250 @@
+/*
+ * Promise2
+ *
+ * Copyright (c) 2016 "0of" Magnus
+ * Licensed under the MIT license.
+ * https://github.com/0of/Promise2/blob/master/LICENSE
+ */
+#ifndef FUSED_RECURSION_PROMISE_INTERNALS_H
+#define FUSED_RECURSION_PROMISE_INTERNALS_H
+
+#include <atomic>
+#include <type_traits>
+#include <utility>
+
+#include "../public/PromisePublicAPIs.h"
+#include "PromiseInternalsBase.h"
+
+namespace Promise2 {
+  namespace Details {
+    //
+    // pipeline stages
+    //  `stage(value, emit)` passes zero or more values to `emit` -> bool(value)
+    //  returns false once no more values wanted
+    //
+
+    template<typename F>
+    class MapStage {
+    private:
+      F _f;
+
+    public:
+      template<typename In> using Out = std::decay_t<decltype(std::declval<F&>()(std::declval<In&&>()))>;
+
+    public:
+      explicit MapStage(F&& f) : _f{ std::move(f) } {}
+
+    public:
+      template<typename V, typename Emit>
+      bool operator() (V&& v, Emit&& emit) {
+        return emit(_f(std::forward<V>(v)));
+      }
+    };
+
+    template<typename Predicate>
+    class FilterStage {
+    private:
+      Predicate _predicate;
+
+    public:
+      template<typename In> using Out = In;
+
+    public:
+      explicit FilterStage(Predicate&& predicate) : _predicate{ std::move(predicate) } {}
+
+    public:
+      template<typename V, typename Emit>
+      bool operator() (V&& v, Emit&& emit) {
+        if (!_predicate(static_cast<const std::decay_t<V>&>(v))) return true;
+        return emit(std::forward<V>(v));
+      }
+    };
+
+    // `F` -> any range of the values
+    template<typename F>
+    class FlatMapStage {
+    private:
+      F _f;
+
+    public:
+      template<typename In> using Out = typename std::decay_t<decltype(std::declval<F&>()(std::declval<In&&>()))>::value_type;
+
+    public:
+      explicit FlatMapStage(F&& f) : _f{ std::move(f) } {}
+
+    public:
+      template<typename V, typename Emit>
+      bool operator() (V&& v, Emit&& emit) {
+        for (auto&& each : _f(std::forward<V>(v))) {
+          if (!emit(std::forward<decltype(each)>(each))) return false;
+        }
+
+        return true;
+      }
+    };
+
+    // the values are counted in the processed order
+    class TakeStage {
+    private:
+      const std::size_t _limit;
+      std::atomic<std::size_t> _taken;
+
+    public:
+      template<typename In> using Out = In;
+
+    public:
+      explicit TakeStage(std::size_t limit) : _limit{ limit }, _taken{ 0 } {}
+
+      // each copy counts from zero
+      TakeStage(const TakeStage& stage) : _limit{ stage._limit }, _taken{ 0 } {}
+
+    public:
+      template<typename V, typename Emit>
+      bool operator() (V&& v, Emit&& emit) {
+        auto taken = _taken.fetch_add(1);
+        if (taken >= _limit) return false;
+
+        return emit(std::forward<V>(v)) && taken + 1 < _limit;
+      }
+    };
+
+    template<typename First, typename Second>
+    class FusedStage {
+    private:
+      First _first;
+      Second _second;
+
+    public:
+      template<typename In> using Out = typename Second::template Out<typename First::template Out<In>>;
+
+    public:
+      FusedStage(First&& first, Second&& second) : _first{ std::move(first) }, _second{ std::move(second) } {}
+
+    public:
+      template<typename V, typename Emit>
+      bool operator() (V&& v, Emit&& emit) {
+        return _first(std::forward<V>(v), [this, &emit](auto&& out) {
+          return _second(std::forward<decltype(out)>(out), emit);
+        });
+      }
+    };
+
+    //
+    // fused PromiseNodeInternal
+    //  all the stages run in one task per value
+    //
+    template<typename ReturnType, typename ArgType, typename Stage>
+    class FusedPromiseNodeInternal : public RecursionPromiseNodeInternalBase<ReturnType, ArgType, std::false_type> {
+      using Base = RecursionPromiseNodeInternalBase<ReturnType, ArgType, std::false_type>;
+
+    private:
+      Stage _stage;
+
+    public:
+      FusedPromiseNodeInternal(Stage&& stage, const std::shared_ptr<ThreadContext>& context)
+        : Base(OnRecursionRejectFunction<ReturnType>{}, context)
+        , _stage{ std::move(stage) }
+      {}
+
+    protected:
+      virtual void onRun(Fulfillment<ArgType, std::false_type>& fulfillment) noexcept override {
+        try {
+          bool wanted = _stage(fulfillment.template get<ArgType>(), [this](auto&& out) {
+            Base::_forward->fulfill(std::forward<decltype(out)>(out));
+            return !Base::isHalted();
+          });
+
+          if (!wanted) {
+            this->halt();
+          }
+        } catch (...) {
+          Base::_forward->reject(std::current_exception());
+        }
+      }
+    };
+  } // Details
+
+  //
+  // @class RecursionPipeline
+  //
+  template<typename T, typename Stage>
+  RecursionPipeline<T, Stage>::RecursionPipeline(const SharedRecursionPromiseNode<T>& source, Stage&& stage)
+    : _source{ source }
+    , _stage{ std::move(stage) }
+  {}
+
+  template<typename T, typename Stage>
+  template<typename F>
+  RecursionPipeline<T, Details::FusedStage<Stage, Details::MapStage<std::decay_t<F>>>> RecursionPipeline<T, Stage>::map(F&& f) const {
+    return { _source, { Stage{ _stage }, Details::MapStage<std::decay_t<F>>{ std::decay_t<F>{ std::forward<F>(f) } } } };
+  }
+
+  template<typename T, typename Stage>
+  template<typename Predicate>
+  RecursionPipeline<T, Details::FusedStage<Stage, Details::FilterStage<std::decay_t<Predicate>>>> RecursionPipeline<T, Stage>::filter(Predicate&& predicate) const {
+    return { _source, { Stage{ _stage }, Details::FilterStage<std::decay_t<Predicate>>{ std::decay_t<Predicate>{ std::forward<Predicate>(predicate) } } } };
+  }
+
+  template<typename T, typename Stage>
+  template<typename F>
+  RecursionPipeline<T, Details::FusedStage<Stage, Details::FlatMapStage<std::decay_t<F>>>> RecursionPipeline<T, Stage>::flatMap(F&& f) const {
+    return { _source, { Stage{ _stage }, Details::FlatMapStage<std::decay_t<F>>{ std::decay_t<F>{ std::forward<F>(f) } } } };
+  }
+
+  template<typename T, typename Stage>
+  RecursionPipeline<T, Details::FusedStage<Stage, Details::TakeStage>> RecursionPipeline<T, Stage>::take(std::size_t n) const {
+    return { _source, { Stage{ _stage }, Details::TakeStage{ n } } };
+  }
+
+  template<typename T, typename Stage>
+  RecursionPromise<typename Stage::template Out<T>> RecursionPipeline<T, Stage>::on(ThreadContext* &&context) const {
+    using NextT = typename Stage::template Out<T>;
+    static_assert(!std::is_void<NextT>::value && !std::is_reference<NextT>::value, "stages must produce value types");
+
+    using Internal = Details::FusedPromiseNodeInternal<NextT, BoxVoid<T>, Stage>;
+    auto sharedContext = std::shared_ptr<ThreadContext>(std::move(context));
+    auto nextNode = std::make_shared<Internal>(Stage{ _stage }, sharedContext);
+    nextNode->haltUpstreamBy(_source);
+
+    _source->chainRecursionNext([=](const Details::SharedPromiseValue<BoxVoid<T>>& v) {
+      auto runnable = Internal::runnableWith(nextNode, v);
+      sharedContext->scheduleToRun(std::move(runnable));
+    }, [=](const Details::SharedPromiseValue<Void>& v) {
+      auto runnable = std::bind(&Internal::finish, nextNode, v);
+      sharedContext->scheduleToRun(std::move(runnable));
+    });
+
+    RecursionPromise<NextT> nextPromise;
+    nextPromise._node = nextNode;
+    return nextPromise;
+  }
+
+  template<typename T>
+  template<typename F>
+  RecursionPipeline<T, Details::MapStage<std::decay_t<F>>> RecursionPromise<T>::map(F&& f) {
+    if (!Base::isValid()) throw std::logic_error("invalid promise");
+    return { Base::_node, Details::MapStage<std::decay_t<F>>{ std::decay_t<F>{ std::forward<F>(f) } } };
+  }
+
+  template<typename T>
+  template<typename Predicate>
+  RecursionPipeline<T, Details::FilterStage<std::decay_t<Predicate>>> RecursionPromise<T>::filter(Predicate&& predicate) {
+    if (!Base::isValid()) throw std::logic_error("invalid promise");
+    return { Base::_node, Details::FilterStage<std::decay_t<Predicate>>{ std::decay_t<Predicate>{ std::forward<Predicate>(predicate) } } };
+  }
+
+  template<typename T>
+  template<typename F>
+  RecursionPipeline<T, Details::FlatMapStage<std::decay_t<F>>> RecursionPromise<T>::flatMap(F&& f) {
+    if (!Base::isValid()) throw std::logic_error("invalid promise");
+    return { Base::_node, Details::FlatMapStage<std::decay_t<F>>{ std::decay_t<F>{ std::forward<F>(f) } } };
+  }
+
+  template<typename T>
+  RecursionPipeline<T, Details::TakeStage> RecursionPromise<T>::take(std::size_t n) {
+    if (!Base::isValid()) throw std::logic_error("invalid promise");
+    return { Base::_node, Details::TakeStage{ n } };
+  }
+}
+
+#endif // FUSED_RECURSION_PROMISE_INTERNALS_H
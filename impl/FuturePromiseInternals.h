@@ -0,0 +1,103 @@
+/*
+ * Promise2
+ *
+ * Copyright (c) 2016 "0of" Magnus
+ * Licensed under the MIT license.
+ * https://github.com/0of/Promise2/blob/master/LICENSE
+ */
+#ifndef FUTURE_PROMISE_INTERNALS_H
+#define FUTURE_PROMISE_INTERNALS_H
+
+#include <algorithm>
+#include <future>
+
+#include "../public/PromisePublicAPIs.h"
+#include "PromiseInternalsBase.h"
+#include "TimerQueue.h"
+
+namespace Promise2 {
+  namespace Details {
+    //
+    // std::future <-> forward
+    //
+    template<typename T>
+    struct FutureBridge {
+      static void fulfill(const DeferPromiseCore<T>& forward, std::future<T>& future) {
+        forward->fulfill(future.get());
+      }
+
+      static void setValue(std::promise<T>& promise, const SharedPromiseValue<T>& value) {
+        promise.set_value(value->template getValue<T>());
+      }
+    };
+
+    template<>
+    struct FutureBridge<void> {
+      static void fulfill(const DeferPromiseCore<void>& forward, std::future<void>& future) {
+        future.get();
+        forward->fulfill(Void{});
+      }
+
+      static void setValue(std::promise<void>& promise, const SharedPromiseValue<Void>&) {
+        promise.set_value();
+      }
+    };
+
+    //
+    // std::future PromiseNodeInternal
+    //  polled on the shared timer thread, so no thread is parked on the future
+    //
+    template<typename T>
+    class FuturePromiseNodeInternal : public PromiseNodeInternalBase<BoxVoid<T>, Void, std::true_type> {
+      using Base = PromiseNodeInternalBase<BoxVoid<T>, Void, std::true_type>;
+      using SelfType = FuturePromiseNodeInternal<T>;
+
+    private:
+      static constexpr const std::chrono::microseconds::rep MinPollingInterval = 50;
+      static constexpr const std::chrono::microseconds::rep MaxPollingInterval = 5000;
+
+    private:
+      std::future<T> _future;
+      std::chrono::microseconds _pollingInterval;
+
+    public:
+      FuturePromiseNodeInternal(std::future<T>&& future, const std::shared_ptr<ThreadContext>& context)
+        : Base(OnRejectFunction<BoxVoid<T>>{}, context)
+        , _future{ std::move(future) }
+        , _pollingInterval{ MinPollingInterval }
+      {}
+
+    public:
+      // never blocks, backs off exponentially while the future is not ready
+      static void poll(const std::shared_ptr<SelfType>& node) {
+        auto status = node->_future.wait_for(std::chrono::seconds(0));
+
+        if (std::future_status::timeout == status) {
+          auto interval = node->_pollingInterval;
+          node->_pollingInterval = std::min(interval * 2, std::chrono::microseconds{ MaxPollingInterval });
+
+          TimerQueue::shared().schedule(interval, [node] { poll(node); });
+          return;
+        }
+
+        // ready or deferred, the deferred one is evaluated lazily within the context
+        auto runnable = std::bind(&SelfType::start, node);
+        node->_context->scheduleToRun(std::move(runnable));
+      }
+
+    protected:
+      virtual void onRun(Fulfillment<Void, std::true_type>&) noexcept override {
+        try {
+          FutureBridge<T>::fulfill(Base::_forward, _future);
+        } catch (...) {
+          Base::_forward->reject(std::current_exception());
+        }
+      }
+    };
+
+    template<typename T> constexpr const std::chrono::microseconds::rep FuturePromiseNodeInternal<T>::MinPollingInterval;
+    template<typename T> constexpr const std::chrono::microseconds::rep FuturePromiseNodeInternal<T>::MaxPollingInterval;
+  } // Details
+}
+
+#endif // FUTURE_PROMISE_INTERNALS_H
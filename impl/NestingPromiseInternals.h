@@ -26,7 +26,7 @@ namespace Promise2 {
       NestingPromiseNodeInternal(OnFulfill&& onFulfill, 
                   OnRejectFunction<ReturnType>&& onReject,
                   const std::shared_ptr<ThreadContext>& context)
-        : Base(std::move(onReject), context)
+        : Base(std::move(onReject), context, NodeKind::Nesting)
         , _onFulfill{ std::move(onFulfill) }
       {}
 
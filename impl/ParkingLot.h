@@ -0,0 +1,69 @@
+/*
+ * Promise2
+ *
+ * Copyright (c) 2016 "0of" Magnus
+ * Licensed under the MIT license.
+ * https://github.com/0of/Promise2/blob/master/LICENSE
+ */
+#ifndef PARKING_LOT_H
+#define PARKING_LOT_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace Promise2 {
+  namespace Details {
+
+    //
+    // @class ParkingLot
+    //  threads park on an address and share a fixed set of buckets,
+    //  so nothing is allocated per waiting promise
+    //
+    class ParkingLot {
+    private:
+      static constexpr const std::size_t BucketCount = 64;
+
+      struct Bucket {
+        std::mutex mutex;
+        std::condition_variable condition;
+      };
+
+      static Bucket& bucketOf(const void *address) {
+        static Bucket buckets[BucketCount];
+        return buckets[(reinterpret_cast<std::uintptr_t>(address) >> 4) % BucketCount];
+      }
+
+    public:
+      // `ready` is checked under the bucket lock, no wake-up gets lost
+      template<typename Pred>
+      static void park(const void *address, Pred&& ready) {
+        auto& bucket = bucketOf(address);
+
+        std::unique_lock<std::mutex> lock{ bucket.mutex };
+        bucket.condition.wait(lock, std::forward<Pred>(ready));
+      }
+
+      template<typename Pred>
+      static bool parkUntil(const void *address, Pred&& ready, std::chrono::steady_clock::time_point deadline) {
+        auto& bucket = bucketOf(address);
+
+        std::unique_lock<std::mutex> lock{ bucket.mutex };
+        return bucket.condition.wait_until(lock, deadline, std::forward<Pred>(ready));
+      }
+
+      // the state must have been published before unparking
+      static void unparkAll(const void *address) {
+        auto& bucket = bucketOf(address);
+        {
+          std::lock_guard<std::mutex> _{ bucket.mutex };
+        }
+
+        bucket.condition.notify_all();
+      }
+    };
+  } // Details
+}
+
+#endif // PARKING_LOT_H
@@ -0,0 +1,215 @@
+/*
+ * Promise2
+ *
+ * Copyright (c) 2016 "0of" Magnus
+ * Licensed under the MIT license.
+ * https://github.com/0of/Promise2/blob/master/LICENSE
+ */
+#ifndef PROMISE_CONTENTION_H
+#define PROMISE_CONTENTION_H
+
+#include "../PromiseConfig.h"
+
+#include <cstdint>
+#include <thread>
+
+#if PROMISE_CONTENTION_STATS
+
+#include <atomic>
+#include <chrono>
+#include <typeinfo>
+#include <vector>
+
+#endif // PROMISE_CONTENTION_STATS
+
+namespace Promise2 {
+  namespace Details {
+
+    // the spin loops guarding the forwards
+    enum class SpinSite : std::uint16_t {
+      // `fulfill/reject` waiting for `chaining` or another producer
+      Settle = 0,
+      // `chaining` waiting for `fulfill/reject`
+      Chain,
+      // `MultiChainForward` chaining again
+      MultiChain,
+      // `MultiChainForward` notifying
+      MultiNotify,
+
+      Count
+    };
+
+#if PROMISE_CONTENTION_STATS
+
+    //
+    // @class ContentionCounters
+    //  one per forward type, only touched once a loop spins so the uncontended path stays as it is
+    //
+    class ContentionCounters {
+    public:
+      struct Site {
+        // the loops spun at least once
+        std::atomic<std::uint64_t> contended{ 0 };
+        std::atomic<std::uint64_t> spins{ 0 };
+        std::atomic<std::uint64_t> yields{ 0 };
+        std::atomic<std::uint64_t> nanoseconds{ 0 };
+      };
+
+    public:
+      const char *const type;
+      ContentionCounters *next;
+
+      Site sites[static_cast<std::size_t>(SpinSite::Count)];
+
+    public:
+      explicit ContentionCounters(const char *typeName)
+        : type{ typeName }
+        , next{ nullptr }
+      {}
+
+    public:
+      template<typename ForwardType>
+      static ContentionCounters& of() {
+        // never freed, the stats are read till exit
+        static ContentionCounters *counters = registered(new ContentionCounters{ typeid(ForwardType).name() });
+        return *counters;
+      }
+
+      static std::atomic<ContentionCounters *>& head() {
+        static std::atomic<ContentionCounters *> counters{ nullptr };
+        return counters;
+      }
+
+    private:
+      static ContentionCounters *registered(ContentionCounters *counters) {
+        auto& list = head();
+        counters->next = list.load(std::memory_order_relaxed);
+        while (!list.compare_exchange_weak(counters->next, counters, std::memory_order_release, std::memory_order_relaxed));
+
+        return counters;
+      }
+
+    private:
+      ContentionCounters(const ContentionCounters& ) = delete;
+      ContentionCounters& operator = (const ContentionCounters& ) = delete;
+    };
+
+    //
+    // @class SpinProbe
+    //  lives through one spin loop, counted into the type once the loop done
+    //
+    template<typename ForwardType>
+    class SpinProbe {
+    private:
+      const SpinSite _site;
+
+      std::uint64_t _spins;
+      std::uint64_t _yields;
+      std::chrono::steady_clock::time_point _begin;
+
+    public:
+      explicit SpinProbe(SpinSite site)
+        : _site{ site }
+        , _spins{ 0 }
+        , _yields{ 0 }
+        , _begin{}
+      {}
+
+      ~SpinProbe() {
+        if (0 == _spins) return;
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _begin).count();
+
+        auto& site = ContentionCounters::of<ForwardType>().sites[static_cast<std::size_t>(_site)];
+        site.contended.fetch_add(1, std::memory_order_relaxed);
+        site.spins.fetch_add(_spins, std::memory_order_relaxed);
+        site.yields.fetch_add(_yields, std::memory_order_relaxed);
+        site.nanoseconds.fetch_add(static_cast<std::uint64_t>(elapsed), std::memory_order_relaxed);
+      }
+
+    public:
+      // one more failed attempt
+      void spin() {
+        if (0 == _spins++) {
+          _begin = std::chrono::steady_clock::now();
+        }
+      }
+
+      void yield() {
+        ++_yields;
+        std::this_thread::yield();
+      }
+
+    private:
+      SpinProbe(const SpinProbe& ) = delete;
+      SpinProbe& operator = (const SpinProbe& ) = delete;
+    };
+
+#else
+
+    template<typename ForwardType>
+    class SpinProbe {
+    public:
+      explicit SpinProbe(SpinSite ) {}
+
+    public:
+      void spin() {}
+
+      void yield() {
+        std::this_thread::yield();
+      }
+    };
+
+#endif // PROMISE_CONTENTION_STATS
+  } // Details
+
+#if PROMISE_CONTENTION_STATS
+
+  namespace Contention {
+    struct SiteStats {
+      // `typeid` name of the forwarded type
+      const char *type;
+      Details::SpinSite site;
+
+      std::uint64_t contended;
+      std::uint64_t spins;
+      std::uint64_t yields;
+      std::uint64_t nanoseconds;
+    };
+
+    // the sites spun so far, each counter read on its own
+    inline std::vector<SiteStats> snapshot() {
+      std::vector<SiteStats> stats;
+
+      for (auto counters = Details::ContentionCounters::head().load(std::memory_order_acquire); counters; counters = counters->next) {
+        for (std::size_t i = 0; i < static_cast<std::size_t>(Details::SpinSite::Count); ++i) {
+          const auto& site = counters->sites[i];
+
+          auto contended = site.contended.load(std::memory_order_relaxed);
+          if (0 == contended) continue;
+
+          stats.push_back(SiteStats{ counters->type, static_cast<Details::SpinSite>(i), contended,
+                                     site.spins.load(std::memory_order_relaxed),
+                                     site.yields.load(std::memory_order_relaxed),
+                                     site.nanoseconds.load(std::memory_order_relaxed) });
+        }
+      }
+
+      return stats;
+    }
+
+    inline const char *nameOf(Details::SpinSite site) {
+      switch (site) {
+        case Details::SpinSite::Settle: return "settle";
+        case Details::SpinSite::Chain: return "chain";
+        case Details::SpinSite::MultiChain: return "multi_chain";
+        case Details::SpinSite::MultiNotify: return "multi_notify";
+        default: return "unknown";
+      }
+    }
+  } // Contention
+
+#endif // PROMISE_CONTENTION_STATS
+}
+
+#endif // PROMISE_CONTENTION_H
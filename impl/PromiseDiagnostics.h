@@ -0,0 +1,222 @@
+/*
+ * Promise2
+ *
+ * Copyright (c) 2016 "0of" Magnus
+ * Licensed under the MIT license.
+ * https://github.com/0of/Promise2/blob/master/LICENSE
+ */
+#ifndef PROMISE_DIAGNOSTICS_H
+#define PROMISE_DIAGNOSTICS_H
+
+#include "../PromiseConfig.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#if PROMISE_LIVE_GAUGES
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <ostream>
+
+#if PROMISE_LEAK_DETECTOR && (defined(__GLIBC__) || defined(__APPLE__))
+# include <cstdlib>
+# include <execinfo.h>
+# define PROMISE_LEAK_BACKTRACE 1
+#else
+# define PROMISE_LEAK_BACKTRACE 0
+#endif
+
+#endif // PROMISE_LIVE_GAUGES
+
+namespace Promise2 {
+  namespace Details {
+
+    enum class NodeKind : std::uint16_t {
+      Task = 0,
+      Then,
+      Deferred,
+      Nesting,
+      Recursion,
+      Resolved,
+
+      Count
+    };
+
+#if PROMISE_LIVE_GAUGES
+
+    class Gauges {
+    public:
+      std::array<std::atomic<std::int64_t>, static_cast<std::size_t>(NodeKind::Count)> nodes;
+      // settled before chained, held by the forwards till chained or destructed
+      std::atomic<std::int64_t> unconsumedValues;
+
+    public:
+      Gauges()
+        : unconsumedValues{ 0 } {
+        for (auto& count : nodes) count.store(0, std::memory_order_relaxed);
+      }
+
+    public:
+      static Gauges& global() {
+        static Gauges gauges;
+        return gauges;
+      }
+    };
+
+    inline void pendValues(std::size_t count) {
+      Gauges::global().unconsumedValues.fetch_add(static_cast<std::int64_t>(count), std::memory_order_relaxed);
+    }
+
+    inline void consumeValues(std::size_t count) {
+      Gauges::global().unconsumedValues.fetch_sub(static_cast<std::int64_t>(count), std::memory_order_relaxed);
+    }
+
+    //
+    // @class LiveNode
+    //  based by every node, counted by its kind while alive
+    //  with `PROMISE_LEAK_DETECTOR` also linked into the live list along with its creation time and backtrace
+    //
+    class LiveNode {
+#if PROMISE_LEAK_DETECTOR
+    public:
+      LiveNode *prev;
+      LiveNode *next;
+
+      std::chrono::steady_clock::time_point createdAt;
+
+# if PROMISE_LEAK_BACKTRACE
+      void *frames[PROMISE_LEAK_BACKTRACE_DEPTH];
+      int depth;
+# endif // PROMISE_LEAK_BACKTRACE
+#endif // PROMISE_LEAK_DETECTOR
+
+    public:
+      const NodeKind kind;
+
+    public:
+      explicit LiveNode(NodeKind nodeKind)
+        : kind{ nodeKind } {
+        Gauges::global().nodes[static_cast<std::size_t>(kind)].fetch_add(1, std::memory_order_relaxed);
+
+#if PROMISE_LEAK_DETECTOR
+        createdAt = std::chrono::steady_clock::now();
+# if PROMISE_LEAK_BACKTRACE
+        depth = ::backtrace(frames, PROMISE_LEAK_BACKTRACE_DEPTH);
+# endif // PROMISE_LEAK_BACKTRACE
+
+        std::lock_guard<std::mutex> _{ mutex() };
+        prev = nullptr;
+        next = head();
+        if (next) next->prev = this;
+        head() = this;
+#endif // PROMISE_LEAK_DETECTOR
+      }
+
+      ~LiveNode() {
+        Gauges::global().nodes[static_cast<std::size_t>(kind)].fetch_sub(1, std::memory_order_relaxed);
+
+#if PROMISE_LEAK_DETECTOR
+        std::lock_guard<std::mutex> _{ mutex() };
+        if (prev) prev->next = next; else head() = next;
+        if (next) next->prev = prev;
+#endif // PROMISE_LEAK_DETECTOR
+      }
+
+#if PROMISE_LEAK_DETECTOR
+    public:
+      static std::mutex& mutex() {
+        static std::mutex lock;
+        return lock;
+      }
+
+      // guarded by `mutex()`
+      static LiveNode *& head() {
+        static LiveNode *nodes = nullptr;
+        return nodes;
+      }
+#endif // PROMISE_LEAK_DETECTOR
+
+    private:
+      LiveNode(const LiveNode& ) = delete;
+      LiveNode& operator = (const LiveNode& ) = delete;
+    };
+
+#else
+
+    inline void pendValues(std::size_t ) {}
+    inline void consumeValues(std::size_t ) {}
+
+    // empty base, takes no space in the nodes
+    class LiveNode {
+    public:
+      explicit LiveNode(NodeKind ) {}
+    };
+
+#endif // PROMISE_LIVE_GAUGES
+  } // Details
+
+#if PROMISE_LIVE_GAUGES
+
+  namespace Diagnostics {
+    using NodeKind = Details::NodeKind;
+
+    inline const char *nameOf(NodeKind kind) {
+      switch (kind) {
+        case NodeKind::Task: return "task";
+        case NodeKind::Then: return "then";
+        case NodeKind::Deferred: return "deferred";
+        case NodeKind::Nesting: return "nesting";
+        case NodeKind::Recursion: return "recursion";
+        case NodeKind::Resolved: return "resolved";
+        default: return "unknown";
+      }
+    }
+
+    inline std::int64_t liveNodes(NodeKind kind) {
+      return Details::Gauges::global().nodes[static_cast<std::size_t>(kind)].load(std::memory_order_relaxed);
+    }
+
+    inline std::int64_t unconsumedValues() {
+      return Details::Gauges::global().unconsumedValues.load(std::memory_order_relaxed);
+    }
+
+#if PROMISE_LEAK_DETECTOR
+
+    // writes the nodes alive longer than `age` with their creation backtraces, returns how many
+    inline std::size_t dumpLeaks(std::ostream& out, std::chrono::milliseconds age = std::chrono::milliseconds(PROMISE_LEAK_THRESHOLD_MS)) {
+      auto now = std::chrono::steady_clock::now();
+      std::size_t leaks = 0;
+
+      std::lock_guard<std::mutex> _{ Details::LiveNode::mutex() };
+
+      for (auto node = Details::LiveNode::head(); node; node = node->next) {
+        auto alive = std::chrono::duration_cast<std::chrono::milliseconds>(now - node->createdAt);
+        if (alive < age) continue;
+
+        out << nameOf(node->kind) << " node " << static_cast<const void *>(node) << " alive for " << alive.count() << "ms\n";
+
+# if PROMISE_LEAK_BACKTRACE
+        if (auto symbols = ::backtrace_symbols(node->frames, node->depth)) {
+          for (int i = 0; i < node->depth; ++i) {
+            out << "  " << symbols[i] << '\n';
+          }
+          std::free(symbols);
+        }
+# endif // PROMISE_LEAK_BACKTRACE
+
+        ++leaks;
+      }
+
+      return leaks;
+    }
+
+#endif // PROMISE_LEAK_DETECTOR
+  } // Diagnostics
+
+#endif // PROMISE_LIVE_GAUGES
+}
+
+#endif // PROMISE_DIAGNOSTICS_H
@@ -1,13 +1,21 @@
 #ifndef PROMISE_INTERNALS_BASE_H
 #define PROMISE_INTERNALS_BASE_H
 
+#include <algorithm>
+#include <chrono>
 #include <thread>
 #include <memory>
 #include <type_traits>
 #include <future>
 #include <vector>
 
+#include "../PromiseConfig.h"
 #include "value/GeneralPromiseValue.h"
+#include "value/PromiseValueRing.h"
+#include "ParkingLot.h"
+#include "PromiseTracing.h"
+#include "PromiseContention.h"
+#include "PromiseDiagnostics.h"
 
 namespace Promise2 {
   namespace Details {
@@ -27,7 +35,9 @@ namespace Promise2 {
 
     enum class ChainedFlag : std::uint16_t {
       No = 0,
-      Yes = 1
+      Yes = 1,
+      // ownership held for storing values or flushing them
+      Busy = 2
     };
 
     enum class RecursionStatus : std::uint16_t {
@@ -64,6 +74,10 @@ namespace Promise2 {
     public:
       virtual bool isFulfilled() const = 0;
       virtual bool isRejected() const = 0;
+
+    public:
+      virtual void wait() const = 0;
+      virtual bool waitFor(std::chrono::nanoseconds timeout) const = 0;
     };
 
     // 
@@ -78,14 +92,24 @@ namespace Promise2 {
       virtual void chainRecursionNext(std::function<void(const SharedPromiseValue<T>&)>&& notify, 
                              std::function<void(const SharedPromiseValue<Void>&)>&& notifyWhenFinished) = 0;
 
-      virtual void chainRecursionNext(const DeferRecursionPromiseCore<T>&) = 0;
+      // values of the recovery are relayed to the given forward, and the finished one to the notify
+      virtual void chainRecursionNext(const DeferRecursionPromiseCore<T>& defer,
+                                      std::function<void(const SharedPromiseValue<Void>&)>&& notifyWhenFinished) = 0;
 
     public:
       virtual void chainNext(std::function<void(const SharedPromiseValue<Void>&)>&& notify) = 0;
 
+    public:
+      // no more values wanted by the receiver, the recursion finishes early
+      virtual void halt() = 0;
+
     public:
       virtual bool isFulfilled() const = 0;
       virtual bool isRejected() const = 0;
+
+    public:
+      virtual void wait() const = 0;
+      virtual bool waitFor(std::chrono::nanoseconds timeout) const = 0;
     };
 
     //
@@ -144,26 +168,34 @@ namespace Promise2 {
       {}
 
     public:
+      SharedPromiseValue<ForwardType> makeValue() {
+        return std::make_shared<typename SharedPromiseValue<ForwardType>::element_type>();
+      }
+
       void onDestructing() {
         if (_aboutToForwardValue) {
           delete _aboutToForwardValue;
           _aboutToForwardValue = nullptr;
+
+          consumeValues(1);
         }
       }
 
       template<typename T>
       void onFulfillBeforeChain(T&& v) {
-        auto sharedValue = std::make_shared<typename SharedPromiseValue<ForwardType>::element_type>();
+        auto sharedValue = makeValue();
         sharedValue->setValue(std::forward<T>(v));
 
         _aboutToForwardValue = new SharedPromiseValue<ForwardType>{ sharedValue };
+        pendValues(1);
       }
 
       void onExceptionBeforeChain(std::exception_ptr e) {
-        auto sharedValue = std::make_shared<typename SharedPromiseValue<ForwardType>::element_type>();
+        auto sharedValue = makeValue();
         sharedValue->setException(e);
 
         _aboutToForwardValue = new SharedPromiseValue<ForwardType>{ sharedValue };
+        pendValues(1);
       }
 
       void onChaining(std::function<void(const SharedPromiseValue<ForwardType>&)>& notify) {
@@ -174,24 +206,53 @@ namespace Promise2 {
           delete _aboutToForwardValue;
 
           _aboutToForwardValue = nullptr;
+
+          consumeValues(1);
         }
       }
     };
 
     template<typename ForwardType>
     class MultiValueForwardTrait {
+      using ValueType = typename SharedPromiseValue<ForwardType>::element_type;
+
+    public:
+      // values shared from the ring, besides the control block
+      static constexpr const bool UseRing = RECURSION_VALUE_RING_SIZE > 0 &&
+                                            !std::is_pointer<ForwardType>::value &&
+                                            !std::is_reference<ForwardType>::value &&
+                                            std::is_trivially_copyable<ForwardType>::value &&
+                                            sizeof(ForwardType) <= PromiseValueRing::CacheLineSize;
+
     private:
       // notify order relaxed
       std::vector<SharedPromiseValue<ForwardType>> *_aboutToForwardValueSet;
+      PromiseValueRing *_ring;
 
     public:
       MultiValueForwardTrait()
         : _aboutToForwardValueSet{ nullptr }
+        , _ring{ UseRing ? new PromiseValueRing(sizeof(ValueType) + ControlBlockSize, RECURSION_VALUE_RING_SIZE) : nullptr }
       {}
 
+      ~MultiValueForwardTrait() {
+        // the living values keep the ring
+        if (_ring) _ring->unref();
+      }
+
     public:
+      SharedPromiseValue<ForwardType> makeValue() {
+        if (_ring) {
+          return std::allocate_shared<ValueType>(PromiseValueRingAllocator<ValueType>{ _ring });
+        }
+
+        return std::make_shared<ValueType>();
+      }
+
       void onDestructing() {
         if (_aboutToForwardValueSet) {
+          consumeValues(_aboutToForwardValueSet->size());
+
           delete _aboutToForwardValueSet;
           _aboutToForwardValueSet = nullptr;
         }
@@ -199,25 +260,17 @@ namespace Promise2 {
 
       template<typename T>
       void onFulfillBeforeChain(T&& v) {
-        auto sharedValue = std::make_shared<typename SharedPromiseValue<ForwardType>::element_type>();
+        auto sharedValue = makeValue();
         sharedValue->setValue(std::forward<T>(v));
 
-        if (!_aboutToForwardValueSet) {
-          _aboutToForwardValueSet = new std::vector<SharedPromiseValue<ForwardType>>{ sharedValue };
-        } else {
-          _aboutToForwardValueSet->push_back(sharedValue);
-        }
+        pend(std::move(sharedValue));
       }
 
       void onExceptionBeforeChain(std::exception_ptr e) {
-        auto sharedValue = std::make_shared<typename SharedPromiseValue<ForwardType>::element_type>();
+        auto sharedValue = makeValue();
         sharedValue->setException(e);
 
-        if (!_aboutToForwardValueSet) {
-          _aboutToForwardValueSet = new std::vector<SharedPromiseValue<ForwardType>>{ sharedValue };
-        } else {
-          _aboutToForwardValueSet->push_back(sharedValue);
-        }
+        pend(std::move(sharedValue));
       }
 
       void onChaining(std::function<void(const SharedPromiseValue<ForwardType>&)>& notify) {
@@ -226,6 +279,8 @@ namespace Promise2 {
           for (auto& eachValue :  *_aboutToForwardValueSet) {
             notify(eachValue);
           }
+
+          consumeValues(_aboutToForwardValueSet->size());
           
           // release the object for being no useful anymore
           delete _aboutToForwardValueSet;
@@ -233,8 +288,29 @@ namespace Promise2 {
           _aboutToForwardValueSet = nullptr;
         }
       }
+
+    private:
+      // the shared count, the allocator and the vtable ahead of the value
+      static constexpr const std::size_t ControlBlockSize = 2 * sizeof(long) + 2 * sizeof(void *);
+
+      void pend(SharedPromiseValue<ForwardType>&& sharedValue) {
+        if (!_aboutToForwardValueSet) {
+          _aboutToForwardValueSet = new std::vector<SharedPromiseValue<ForwardType>>{};
+          // grows once per ring round at most
+          _aboutToForwardValueSet->reserve(std::max<std::size_t>(RECURSION_VALUE_RING_SIZE, 1));
+        }
+
+        _aboutToForwardValueSet->push_back(std::move(sharedValue));
+        pendValues(1);
+      }
+
+      MultiValueForwardTrait(const MultiValueForwardTrait&) = delete;
+      MultiValueForwardTrait& operator = (const MultiValueForwardTrait&) = delete;
     };
 
+    template<typename ForwardType>
+    constexpr const bool MultiValueForwardTrait<ForwardType>::UseRing;
+
     //
     // forward traits
     //
@@ -242,7 +318,9 @@ namespace Promise2 {
     class Forward {
     private:
       std::atomic<ChainedFlag> _chainedFlag;
-      Status _status;
+      std::atomic<Status> _status;
+      // parked threads, settling skips the wake-up if none
+      mutable std::atomic<std::uint32_t> _waiters;
 
     protected:
       std::function<void(const SharedPromiseValue<ForwardType>&)> _forwardNotify;
@@ -254,6 +332,7 @@ namespace Promise2 {
       Forward()
         : _chainedFlag{ ChainedFlag::No }
         , _status { Status::Running }
+        , _waiters{ 0 }
         , _forwardNotify{}
       {}
 
@@ -280,16 +359,13 @@ namespace Promise2 {
 
       template<typename T>
       void fulfill(T&& value) {
-        // acquire ownership
-        auto preFlag = _chainedFlag.exchange(ChainedFlag::Yes);
-
-        // already chained
-        if (ChainedFlag::Yes == preFlag) {
+        // already chained, otherwise ownership acquired
+        if (acquireUnlessChained()) {
           // just fire the notification with forward notifier
-          auto sharedValue = std::make_shared<typename SharedPromiseValue<ForwardType>::element_type>();
+          auto sharedValue = _forwardTrait.makeValue();
           sharedValue->setValue(std::forward<T>(value));
 
-          _status = Status::Fulfilled;
+          settle(Status::Fulfilled);
 
           this->notify(sharedValue);
 
@@ -298,24 +374,21 @@ namespace Promise2 {
           // store the value for future notification
           _forwardTrait.onFulfillBeforeChain(std::forward<T>(value));
 
-          // exchange back to prevous flag cuz `doChaining` may be waiting for the condition desperately
+          // release the ownership cuz `doChaining` or other producers may be waiting for the condition desperately
           _chainedFlag.store(ChainedFlag::No);
 
-          _status = Status::Fulfilled;
+          settle(Status::Fulfilled);
         }
       }
         
       void reject(std::exception_ptr exception) {
-        // acquire ownership
-        auto preFlag = _chainedFlag.exchange(ChainedFlag::Yes);
-
-        // already chained
-        if (ChainedFlag::Yes == preFlag) {
+        // already chained, otherwise ownership acquired
+        if (acquireUnlessChained()) {
           // just fire the notification with forward notifier
-          auto sharedValue = std::make_shared<typename SharedPromiseValue<ForwardType>::element_type>();
+          auto sharedValue = _forwardTrait.makeValue();
           sharedValue->setException(exception);
 
-          _status = Status::Rejected;
+          settle(Status::Rejected);
 
           this->notify(sharedValue);
 
@@ -324,15 +397,37 @@ namespace Promise2 {
           // store the value for future notification
           _forwardTrait.onExceptionBeforeChain(exception);
 
-          // exchange back to prevous flag cuz `doChaining` may be waiting for the condition desperately
+          // release the ownership cuz `doChaining` or other producers may be waiting for the condition desperately
           _chainedFlag.store(ChainedFlag::No);
 
-          _status = Status::Rejected;
+          settle(Status::Rejected);
+        }
+      }
+
+      // forwards the settled value as it is once chained, copied into the trait otherwise
+      void relay(const SharedPromiseValue<ForwardType>& value) {
+        auto status = value->isExceptionCase() ? Status::Rejected : Status::Fulfilled;
+
+        if (acquireUnlessChained()) {
+          settle(status);
+
+          this->notify(value);
+
+        } else {
+          if (Status::Rejected == status) {
+            _forwardTrait.onExceptionBeforeChain(value->fetchException());
+          } else {
+            _forwardTrait.onFulfillBeforeChain(value->template getValue<ForwardType>());
+          }
+
+          _chainedFlag.store(ChainedFlag::No);
+
+          settle(status);
         }
       }
 
       bool hasChained() const {
-        return _chainedFlag.load();
+        return _chainedFlag.load() == ChainedFlag::Yes;
       }
 
       bool isFulfilled() const {
@@ -343,6 +438,34 @@ namespace Promise2 {
         return _status == Status::Rejected;
       }
 
+      bool isSettled() const {
+        return _status != Status::Running;
+      }
+
+      // park the calling thread till settled
+      void wait() const {
+        if (isSettled()) return;
+
+        ++_waiters;
+#if USE_ATOMIC_WAIT
+        _status.wait(Status::Running);
+#else
+        ParkingLot::park(this, [this] { return isSettled(); });
+#endif // USE_ATOMIC_WAIT
+        --_waiters;
+      }
+
+      bool waitFor(std::chrono::nanoseconds timeout) const {
+        if (isSettled()) return true;
+
+        ++_waiters;
+        // `std::atomic::wait` has no timed version
+        auto settled = ParkingLot::parkUntil(this, [this] { return isSettled(); }, std::chrono::steady_clock::now() + timeout);
+        --_waiters;
+
+        return settled;
+      }
+
     protected:
       virtual void notify(const SharedPromiseValue<ForwardType>& value) {
         std::atomic_thread_fence(std::memory_order_acquire);
@@ -363,25 +486,65 @@ namespace Promise2 {
       }
 
     private:
-      // thread safe chaining
-      void chaining() {
+      void settle(Status status) {
+        PROMISE_TRACE(Status::Fulfilled == status ? "fulfill" : "reject", this);
+
+        _status.store(status);
+
+        if (_waiters.load() > 0) {
+#if USE_ATOMIC_WAIT
+          _status.notify_all();
+#endif // USE_ATOMIC_WAIT
+          ParkingLot::unparkAll(this);
+        }
+      }
+
+      // true if already chained, otherwise returns with the ownership acquired
+      //  concurrent producers are serialized till chained
+      bool acquireUnlessChained() {
+        auto flag = _chainedFlag.load();
+        SpinProbe<ForwardType> probe{ SpinSite::Settle };
+
         while (true) {
-          // acquire only if is `no` flag
-          auto preFlag = _chainedFlag.exchange(ChainedFlag::Yes);
+          if (ChainedFlag::Yes == flag) {
+            return true;
+          }
 
-          // means `fulfill/reject` has acquired ownership
-          if (ChainedFlag::Yes == preFlag) {
-            std::this_thread::yield();
-            continue;
+          if (ChainedFlag::No == flag && _chainedFlag.compare_exchange_weak(flag, ChainedFlag::Busy)) {
+            return false;
           }
 
-          // ownership acquired 
-          // notify with previously stored value
-          _forwardTrait.onChaining(_forwardNotify);
+          probe.spin();
 
-          break;
+          // means `fulfill/reject` or `chaining` has acquired ownership
+          if (ChainedFlag::Busy == flag) {
+            probe.yield();
+            flag = _chainedFlag.load();
+          }
         }
       }
+
+      // thread safe chaining
+      void chaining() {
+        auto flag = ChainedFlag::No;
+        SpinProbe<ForwardType> probe{ SpinSite::Chain };
+
+        // acquire only if is `no` flag
+        while (!_chainedFlag.compare_exchange_weak(flag, ChainedFlag::Busy)) {
+          // means `fulfill/reject` has acquired ownership
+          flag = ChainedFlag::No;
+          probe.spin();
+          probe.yield();
+        }
+
+        // ownership acquired 
+        // notify with previously stored value
+        _forwardTrait.onChaining(_forwardNotify);
+
+        _chainedFlag.store(ChainedFlag::Yes);
+
+        PROMISE_TRACE("chain", this);
+      }
     };
 
     template<typename ForwardType, template<typename T> class ForwardTrait>
@@ -409,9 +572,11 @@ namespace Promise2 {
       public:
         void lock() {
           std::uint32_t flag = 0;
+          SpinProbe<ForwardType> probe{ SpinSite::MultiChain };
 
           while ((flag = _flags->fetch_or(0x1)) & 0x1) {
-            std::this_thread::yield();
+            probe.spin();
+            probe.yield();
           }
 
           alreadyChained = (flag & 0x10) == 0x10;
@@ -433,8 +598,11 @@ namespace Promise2 {
 
       public:
         void lock() {
+          SpinProbe<ForwardType> probe{ SpinSite::MultiNotify };
+
           while (_flags->fetch_or(0x1) & 0x1) {
-            std::this_thread::yield();
+            probe.spin();
+            probe.yield();
           }
         }
 
@@ -443,6 +611,12 @@ namespace Promise2 {
         }
       };
 
+    public:
+      MultiChainForward()
+        : Base()
+        , _flags{ 0 }
+      {}
+
     public:
       virtual void doChaining(const DeferPromiseCore<ForwardType>& nextForward) {
         ChainingMutex mutex{ &_flags };
@@ -476,7 +650,7 @@ namespace Promise2 {
     };
 
     template<typename ReturnType, typename ArgType, typename IsTask>
-    class PromiseNodeInternalBase : public PromiseNode<ReturnType> {
+    class PromiseNodeInternalBase : public PromiseNode<ReturnType>, private LiveNode {
     protected:
       DeferPromiseCore<ReturnType> _forward;
       std::shared_ptr<ThreadContext> _context;
@@ -485,12 +659,15 @@ namespace Promise2 {
       
     public:
       PromiseNodeInternalBase(OnRejectFunction<ReturnType>&& onReject,
-                  const std::shared_ptr<ThreadContext>& context)
+                  const std::shared_ptr<ThreadContext>& context,
+                  NodeKind kind = IsTask::value ? NodeKind::Task : NodeKind::Then)
         : PromiseNode<ReturnType>()
+        , LiveNode{ kind }
         , _forward{ std::make_unique<Forward<ReturnType, SingleValueForwardTrait>>() }
         , _context{ context }
-        , _onReject{ std::move(onReject) }
-      {}
+        , _onReject{ std::move(onReject) } {
+        PROMISE_TRACE_LINK("create", this, _forward.get());
+      }
 
     public:
       virtual void chainNext(const DeferPromiseCore<ReturnType>& nextForward) override {
@@ -510,17 +687,29 @@ namespace Promise2 {
         return _forward->isRejected();
       }
 
+      virtual void wait() const override {
+        _forward->wait();
+      }
+
+      virtual bool waitFor(std::chrono::nanoseconds timeout) const override {
+        return _forward->waitFor(timeout);
+      }
+
     public:
       void runWith(const SharedPromiseValue<ArgType>& value) {
+        PROMISE_TRACE_BEGIN("run", this);
+
         Fulfillment<ArgType, IsTask> fulfillment { value };
         try {
           fulfillment.guard();
         } catch (...) {
           this->runReject();
+          PROMISE_TRACE_END("run", this);
           return;
         }
 
         this->onRun(fulfillment);
+        PROMISE_TRACE_END("run", this);
       }
 
       // start as task
@@ -556,11 +745,58 @@ namespace Promise2 {
       PromiseNodeInternalBase(const PromiseNodeInternalBase&) = delete;
     };
 
+    //
+    // @class FinishBarrier
+    //  the finished notification waits for the upstream and every recovery recursion chained by `onReject`
+    //  rejected with the first exception
+    //
+    class FinishBarrier {
+    private:
+      // the upstream one is pending from the beginning
+      std::atomic<std::uint32_t> _pending;
+      std::atomic_flag _failed;
+      std::exception_ptr _exception;
+
+    public:
+      FinishBarrier()
+        : _pending{ 1 }
+        , _exception{}
+      {
+        _failed.clear();
+      }
+
+    public:
+      // false if already finished, too late to wait for another one
+      bool join() {
+        auto pending = _pending.load();
+
+        while (pending > 0) {
+          if (_pending.compare_exchange_weak(pending, pending + 1)) return true;
+        }
+
+        return false;
+      }
+
+      // true if it is the last one arrived
+      bool arrive(std::exception_ptr e) {
+        if (e && !_failed.test_and_set()) {
+          _exception = e;
+        }
+
+        return 1 == _pending.fetch_sub(1);
+      }
+
+      // valid only after the last one arrived
+      std::exception_ptr exception() const {
+        return _exception;
+      }
+    };
+
     //
     // RecursionPromiseNodeInternalBase
     //
     template<typename ReturnType, typename ArgType, typename IsTask>
-    class RecursionPromiseNodeInternalBase : public RecursionPromiseNode<ReturnType> {
+    class RecursionPromiseNodeInternalBase : public RecursionPromiseNode<ReturnType>, private LiveNode {
     protected:
       DeferRecursionPromiseCore<ReturnType> _forward;
       DeferPromiseCore<Void> _finishForward;
@@ -568,15 +804,34 @@ namespace Promise2 {
 
       OnRecursionRejectFunction<ReturnType> _onReject;
 
+      std::atomic_bool _halted;
+      // set before chained
+      std::function<void()> _haltUpstream;
+
+      // shared with the recovery recursions which may outlive the node
+      std::shared_ptr<FinishBarrier> _finishBarrier;
+
     protected:
       RecursionPromiseNodeInternalBase(OnRecursionRejectFunction<ReturnType>&& onReject, 
                                        const std::shared_ptr<ThreadContext>& context)
+        : RecursionPromiseNodeInternalBase(std::move(onReject), context, std::make_unique<Forward<ReturnType, MultiValueForwardTrait>>())
+      {}
+
+      // with a specialized forward
+      RecursionPromiseNodeInternalBase(OnRecursionRejectFunction<ReturnType>&& onReject,
+                                       const std::shared_ptr<ThreadContext>& context,
+                                       DeferRecursionPromiseCore<ReturnType>&& forward)
         : RecursionPromiseNode<ReturnType>()
-        , _forward{ std::make_unique<Forward<ReturnType, MultiValueForwardTrait>>() }
+        , LiveNode{ NodeKind::Recursion }
+        , _forward{ std::move(forward) }
         , _finishForward{ std::make_unique<MultiChainForward<Void, SingleValueForwardTrait>>() }
         , _context{ context }
         , _onReject{ std::move(onReject) }
-      {}
+        , _halted{ false }
+        , _haltUpstream{}
+        , _finishBarrier{ std::make_shared<FinishBarrier>() } {
+        PROMISE_TRACE_LINK("create", this, _forward.get());
+      }
 
     public:
       virtual void chainRecursionNext(std::function<void(const SharedPromiseValue<ReturnType>&)>&& notify,
@@ -586,8 +841,13 @@ namespace Promise2 {
         _finishForward->doChaining(std::move(notifyWhenFinished));
       }
 
-      virtual void chainRecursionNext(const DeferRecursionPromiseCore<ReturnType>& defer) override {
-        throw 0;
+      virtual void chainRecursionNext(const DeferRecursionPromiseCore<ReturnType>& defer,
+                                      std::function<void(const SharedPromiseValue<Void>&)>&& notifyWhenFinished) override {
+        // the recovery values are relayed one by one, nothing buffered once chained
+        _forward->doChaining([defer](const SharedPromiseValue<ReturnType>& value) {
+          defer->relay(value);
+        });
+        _finishForward->doChaining(std::move(notifyWhenFinished));
       }
 
     public:
@@ -595,6 +855,25 @@ namespace Promise2 {
         _finishForward->doChaining(std::move(notify));
       }
 
+    public:
+      virtual void halt() override {
+        if (!_halted.exchange(true) && _haltUpstream) {
+          _haltUpstream();
+        }
+      }
+
+      // halting propagates to the previous recursion
+      template<typename SharedUpstreamNode>
+      void haltUpstreamBy(const SharedUpstreamNode& upstream) {
+        _haltUpstream = [weak = std::weak_ptr<typename SharedUpstreamNode::element_type>(upstream)] {
+          if (auto node = weak.lock()) node->halt();
+        };
+      }
+
+      bool isHalted() const {
+        return _halted.load(std::memory_order_relaxed);
+      }
+
     public:
       virtual bool isFulfilled() const override {
         return _finishForward->isFulfilled();
@@ -604,17 +883,29 @@ namespace Promise2 {
         return _finishForward->isRejected();
       }
 
+      virtual void wait() const override {
+        _finishForward->wait();
+      }
+
+      virtual bool waitFor(std::chrono::nanoseconds timeout) const override {
+        return _finishForward->waitFor(timeout);
+      }
+
     public:
       void runWith(const SharedPromiseValue<ArgType>& value) {
+        PROMISE_TRACE_BEGIN("run", this);
+
         Fulfillment<ArgType, IsTask> fulfillment { value };
         try {
           fulfillment.guard();
         } catch (...) {
           this->runReject();
+          PROMISE_TRACE_END("run", this);
           return;
         }
 
         this->onRun(fulfillment);
+        PROMISE_TRACE_END("run", this);
       }
 
       // start as task
@@ -623,16 +914,27 @@ namespace Promise2 {
         this->runWith(nullptr);
       }
 
+      // the runnable scheduled for a value, otherwise the finish scheduled separately may run ahead of it
+      //  joined on the notifying thread, not waited for if finished already
+      template<typename SharedNode>
+      static std::function<void()> runnableWith(const SharedNode& node, const SharedPromiseValue<ArgType>& value) {
+        if (node->_finishBarrier->join()) {
+          return std::bind(&RecursionPromiseNodeInternalBase::runJoined, node, value);
+        }
+
+        return std::bind(&RecursionPromiseNodeInternalBase::runWith, node, value);
+      }
+
       void finish(const SharedPromiseValue<Void>& value) {
         Fulfillment<Void, std::false_type> fulfillment { value };
         try {
           fulfillment.guard();
         } catch (...) {
-          _finishForward->reject(std::current_exception());
+          arrive(_finishBarrier, _finishForward, std::current_exception());
           return;
         }
 
-        _finishForward->fulfill(Void{});
+        arrive(_finishBarrier, _finishForward, nullptr);
       }
 
     protected:
@@ -645,7 +947,7 @@ namespace Promise2 {
             // chain the returned promise only if valid 
             auto p = _onReject(std::current_exception());
             if (p.isValid()) {
-              p.internal()->chainRecursionNext(_forward);
+              chainRecovery(p.internal());
             } else {
               _forward->reject(std::current_exception());
             }
@@ -656,6 +958,50 @@ namespace Promise2 {
           _forward->reject(std::current_exception());
         }
       }
+
+    protected:
+      void runJoined(const SharedPromiseValue<ArgType>& value) {
+        this->runWith(value);
+
+        arrive(_finishBarrier, _finishForward, nullptr);
+      }
+
+      template<typename SharedRecoveryNode>
+      void chainRecovery(const SharedRecoveryNode& recovery) {
+        if (isHalted()) recovery->halt();
+
+        auto barrier = _finishBarrier;
+        auto finishForward = _finishForward;
+
+        if (!barrier->join()) {
+          // finished already, the values are still relayed
+          recovery->chainRecursionNext(_forward, [](const SharedPromiseValue<Void>&) {});
+          return;
+        }
+
+        // the forwards are shared, the node may be gone when the recovery finished
+        recovery->chainRecursionNext(_forward, [barrier, finishForward](const SharedPromiseValue<Void>& value) {
+          std::exception_ptr e;
+          if (!value->hasAssigned()) {
+            e = std::make_exception_ptr(std::logic_error("invalid promise state"));
+          } else if (value->isExceptionCase()) {
+            e = value->fetchException();
+          }
+
+          arrive(barrier, finishForward, e);
+        });
+      }
+
+    private:
+      static void arrive(const std::shared_ptr<FinishBarrier>& barrier, const DeferPromiseCore<Void>& finishForward, std::exception_ptr e) {
+        if (!barrier->arrive(e)) return;
+
+        if (auto exception = barrier->exception()) {
+          finishForward->reject(exception);
+        } else {
+          finishForward->fulfill(Void{});
+        }
+      }
     };
 
     //
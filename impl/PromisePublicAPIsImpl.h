@@ -15,6 +15,14 @@
 
 #include "ResolvedRejectedPromiseInternals.h"
 #include "RecursionPromiseInternals.h"
+#include "BoundedRecursionPromiseInternals.h"
+#include "ReduceRecursionPromiseInternals.h"
+#include "DeferredRecursionPromiseInternals.h"
+#include "FusedRecursionPromiseInternals.h"
+#include "TimeoutPromiseInternals.h"
+#include "FuturePromiseInternals.h"
+#include "RetryPromiseInternals.h"
+#include "CoroutinePromiseInternals.h"
 
 namespace Promise2 {
 
@@ -70,6 +78,7 @@ namespace Promise2 {
    auto node = std::make_shared<Internal>(eliminateVoid<ArgPred>(std::move(task)), \
                   std::function<Promise<T>(std::exception_ptr)>(), sharedContext); \
    auto runnable = std::bind(&Internal::start, node); \
+   PROMISE_TRACE("schedule", node.get()); \
    sharedContext->scheduleToRun(std::move(runnable)); \
    \
    spawned._node = node; \
@@ -82,6 +91,7 @@ namespace Promise2 {
     auto nextNode = std::make_shared<Internal>(std::move(onFulfill), std::move(onReject), sharedContext); \
     node->chainNext([=](const Details::SharedPromiseValue<BoxVoid<T>>& v) { \
       auto runnable = std::bind(&Internal::runWith, nextNode, v); \
+      PROMISE_TRACE("schedule", nextNode.get()); \
       sharedContext->scheduleToRun(std::move(runnable)); \
     }); \
     \
@@ -94,11 +104,14 @@ namespace Promise2 {
     using Internal = internal<BoxVoid<NextT>, BoxVoid<T>, BoxVoid<ConvertibleT>, std::false_type, true>; \
     auto sharedContext = std::shared_ptr<ThreadContext>(std::move(context)); \
     auto nextNode = std::make_shared<Internal>(std::move(onFulfill), std::move(onReject), sharedContext); \
+    nextNode->haltUpstreamBy(node); \
     node->chainRecursionNext([=](const Details::SharedPromiseValue<BoxVoid<T>>& v) { \
-      auto runnable = std::bind(&Internal::runWith, nextNode, v); \
+      auto runnable = Internal::runnableWith(nextNode, v); \
+      PROMISE_TRACE("schedule", nextNode.get()); \
       sharedContext->scheduleToRun(std::move(runnable)); \
     }, [=](const Details::SharedPromiseValue<Void>& v) { \
       auto runnable = std::bind(&Internal::finish, nextNode, v); \
+      PROMISE_TRACE("schedule", nextNode.get()); \
       sharedContext->scheduleToRun(std::move(runnable)); \
     }); \
     \
@@ -166,6 +179,38 @@ namespace Promise2 {
   }
 #endif // NESTING_PROMISE
 
+  template<typename T>
+  Promise<T> PromiseSpawner<T>::FromFuture(std::future<T>&& future, ThreadContext* &&context) {
+    using Internal = Details::FuturePromiseNodeInternal<T>;
+
+    if (!future.valid()) throw std::future_error(std::future_errc::no_state);
+
+    Promise<T> spawned;
+    auto sharedContext = std::shared_ptr<ThreadContext>(std::move(context));
+    auto node = std::make_shared<Internal>(std::move(future), sharedContext);
+    Internal::poll(node);
+
+    spawned._node = node;
+    return spawned;
+  }
+
+  template<typename T>
+  Promise<T> PromiseSpawner<T>::Spawn(std::function<Promise<T>()>&& taskFactory, const RetryPolicy& policy, ThreadContext* &&context) {
+    using Internal = Details::RetryPromiseNodeInternal<T>;
+
+    if (0 == policy.maxAttempts) throw std::invalid_argument("no attempt allowed");
+
+    Promise<T> spawned;
+    auto sharedContext = std::shared_ptr<ThreadContext>(std::move(context));
+    auto node = std::make_shared<Internal>(std::move(taskFactory), policy, sharedContext);
+
+    auto runnable = std::bind(&Internal::attempt, node);
+    sharedContext->scheduleToRun(std::move(runnable));
+
+    spawned._node = node;
+    return spawned;
+  }
+
   template<typename T>
   template<class SharedNode, typename NextT, typename ConvertibleT>
   Promise<UnboxVoid<NextT>> PromiseThenable<T>::Then(SharedNode& node,
@@ -220,8 +265,121 @@ namespace Promise2 {
                                                                        ThreadContext* &&context) 
     RECUR_THEN_IMPL(Details::PromiseNodeInternal, T, ConvertibleT, ArgTypePred)
 
+  template<typename T>
+  template<typename NextT, typename ConvertibleT>
+  RecursionPromise<UnboxVoid<NextT>> OrderedRecursionPromiseThenable<T>::Then(SharedRecursionPromiseNode<T>& node,
+                                                                              std::function<NextT(ConvertibleT)>&& onFulfill,
+                                                                              OnRecursionRejectFunction<NextT>&& onReject,
+                                                                              ThreadContext* &&context,
+                                                                              std::size_t window) {
+    static_assert(std::is_convertible<T, ConvertibleT>::value, "implicitly argument type conversion failed");
+
+    using Internal = Details::OrderedPromiseNodeInternal<BoxVoid<NextT>, BoxVoid<T>, BoxVoid<ConvertibleT>>;
+    auto sharedContext = std::shared_ptr<ThreadContext>(std::move(context));
+    auto nextNode = std::make_shared<Internal>(std::move(onFulfill), std::move(onReject), sharedContext, window);
+    nextNode->haltUpstreamBy(node);
+
+    node->chainRecursionNext([=](const Details::SharedPromiseValue<BoxVoid<T>>& v) {
+      Internal::dispatch(nextNode, v);
+    }, [=](const Details::SharedPromiseValue<Void>& v) {
+      // held till drained, the last emitting task forwards it
+      Internal::finishWith(nextNode, v);
+    });
+
+    RecursionPromise<UnboxVoid<NextT>> nextPromise;
+    nextPromise._node = nextNode;
+    return nextPromise;
+  }
+
   template<typename SharedPromiseNodeType> bool GenericPromise<SharedPromiseNodeType>::isFulfilled() const CALL_NODE_IMP(isFulfilled)
   template<typename SharedPromiseNodeType> bool GenericPromise<SharedPromiseNodeType>::isRejected() const CALL_NODE_IMP(isRejected)
+  template<typename SharedPromiseNodeType> void GenericPromise<SharedPromiseNodeType>::wait() const CALL_NODE_IMP(wait)
+
+  template<typename SharedPromiseNodeType>
+  template<typename Rep, typename Period>
+  bool GenericPromise<SharedPromiseNodeType>::wait_for(const std::chrono::duration<Rep, Period>& timeout) const {
+    if (!_node) {
+      throw std::logic_error("invalid promise");
+    }
+
+    return _node->waitFor(std::chrono::duration_cast<std::chrono::nanoseconds>(timeout));
+  }
+
+  namespace Details {
+    // park on the unchained core and then take its stored value synchronously
+    template<typename T>
+    T waitAndTake(const DeferPromiseCore<T>& core) {
+      core->wait();
+
+      SharedPromiseValue<BoxVoid<T>> value;
+      core->doChaining([&value](const SharedPromiseValue<BoxVoid<T>>& v) {
+        value = v;
+      });
+
+      value->accessGuard();
+      return static_cast<T>(value->template getValue<BoxVoid<T>&&>());
+    }
+  } // Details
+
+  template<typename T>
+  template<typename OnFulfill>
+  PromiseContinuation<T, std::decay_t<OnFulfill>> Promise<T>::thenInline(OnFulfill&& onFulfill) {
+    if (!Base::isValid()) throw std::logic_error("invalid promise");
+    return { *this, std::decay_t<OnFulfill>{ std::forward<OnFulfill>(onFulfill) } };
+  }
+
+  template<typename T>
+  T Promise<T>::get() {
+    if (!Base::isValid()) throw std::logic_error("invalid promise");
+
+    Details::DeferPromiseCore<T> core = std::make_shared<Details::Forward<BoxVoid<T>, Details::SingleValueForwardTrait>>();
+    Base::_node->chainNext(core);
+
+    return Details::waitAndTake<T>(core);
+  }
+
+  template<typename T>
+  std::future<T> Promise<T>::toFuture() {
+    if (!Base::isValid()) throw std::logic_error("invalid promise");
+
+    auto promise = std::make_shared<std::promise<T>>();
+    auto future = promise->get_future();
+
+    Base::_node->chainNext([promise](const Details::SharedPromiseValue<BoxVoid<T>>& v) {
+      if (v->isExceptionCase()) {
+        promise->set_exception(v->fetchException());
+      } else {
+        Details::FutureBridge<T>::setValue(*promise, v);
+      }
+    });
+
+    return future;
+  }
+
+#if USE_COROUTINE
+  template<typename T>
+  Details::PromiseAwaiter<T> Promise<T>::resumeOn(ThreadContext* &&context) {
+    if (!Base::isValid()) throw std::logic_error("invalid promise");
+
+    return Details::PromiseAwaiter<T>{ Base::_node, std::shared_ptr<ThreadContext>(std::move(context)) };
+  }
+#endif // USE_COROUTINE
+
+  template<typename T>
+  void RecursionPromise<T>::get() {
+    if (!Base::isValid()) throw std::logic_error("invalid promise");
+
+    Details::DeferPromiseCore<void> core = std::make_shared<Details::Forward<Void, Details::SingleValueForwardTrait>>();
+    Base::_node->chainNext([core](const Details::SharedPromiseValue<Void>& v) {
+      if (v->isExceptionCase()) {
+        core->reject(v->fetchException());
+      } else {
+        core->fulfill(Void{});
+      }
+    });
+
+    Details::waitAndTake<void>(core);
+  }
 
   template<typename T>
   template<typename ArgType>
@@ -258,9 +416,161 @@ namespace Promise2 {
     return spawned;
   }
 
+  template<typename T>
+  template<typename Rep, typename Period>
+  Promise<T> Promise<T>::timeout(const std::chrono::duration<Rep, Period>& duration,
+                                 ThreadContext* &&context) {
+    using Internal = Details::TimeoutPromiseNodeInternal<BoxVoid<T>>;
+
+    if (!Base::isValid()) throw std::logic_error("invalid promise");
+
+    auto sharedContext = std::shared_ptr<ThreadContext>(std::move(context));
+    auto nextNode = std::make_shared<Internal>(sharedContext);
+
+    // arm before chaining, the source may have been settled already
+    Internal::arm(nextNode, std::chrono::duration_cast<Details::TimerQueue::Clock::duration>(duration));
+
+    Base::_node->chainNext([=](const Details::SharedPromiseValue<BoxVoid<T>>& v) {
+      if (nextNode->acquire()) {
+        nextNode->disarm();
+
+        auto runnable = std::bind(&Internal::runWith, nextNode, v);
+        sharedContext->scheduleToRun(std::move(runnable));
+      }
+    });
+
+    Promise<T> nextPromise;
+    nextPromise._node = nextNode;
+    return nextPromise;
+  }
+
   template<typename T>
   template<class InputIterator>
   RecursionPromise<T> PromiseRecursible<T>::Iterate(InputIterator begin, InputIterator end, ThreadContext* &&context) {
+    return Iterate(begin, end, std::move(context), Details::IsRandomAccessIterator<InputIterator>{});
+  }
+
+  namespace Details {
+    // measures every task scheduled under the label
+    class LabelledContext : public ThreadContext {
+    private:
+      std::unique_ptr<ThreadContext> _context;
+      LabelStats *_stats;
+
+    public:
+      LabelledContext(ThreadContext* &&context, const Label& label)
+        : _context{ context }
+        , _stats{ label.stats() }
+      {}
+
+    public:
+      virtual void scheduleToRun(std::function<void()>&& task) override {
+        _context->scheduleToRun([stats = _stats, task = std::move(task)] {
+          LabelScope _{ stats };
+          task();
+        });
+      }
+    };
+  } // Details
+
+  template<typename T>
+  template<class InputIterator>
+  RecursionPromise<T> PromiseRecursible<T>::Iterate(InputIterator begin, InputIterator end, ThreadContext* &&context, const Label& label) {
+    return Iterate(begin, end, new Details::LabelledContext{ std::move(context), label });
+  }
+
+  template<typename T>
+  template<typename Acc, typename Combine, typename Merge>
+  Promise<Acc> RecursionPromise<T>::reduce(Acc identity, Combine&& combine, Merge&& merge, ThreadContext* &&context) {
+    static_assert(!std::is_void<T>::value && !std::is_reference<T>::value, "reduce requires value types");
+
+    if (!Base::isValid()) throw std::logic_error("invalid promise");
+
+    using Internal = Details::ReducePromiseNodeInternal<Acc, T>;
+    auto sharedContext = std::shared_ptr<ThreadContext>(std::move(context));
+    auto node = std::make_shared<Internal>(identity,
+                                           std::function<Acc(Acc, const T&)>{ std::forward<Combine>(combine) },
+                                           std::function<Acc(Acc, Acc)>{ std::forward<Merge>(merge) },
+                                           sharedContext);
+
+    Base::_node->chainRecursionNext([=](const Details::SharedPromiseValue<T>& v) {
+      node->accumulate(v);
+    }, [=](const Details::SharedPromiseValue<Void>& v) {
+      auto runnable = std::bind(&Internal::merge, node, v);
+      sharedContext->scheduleToRun(std::move(runnable));
+    });
+
+    Promise<Acc> reduced;
+    reduced._node = node;
+    return reduced;
+  }
+
+  template<typename T>
+  RecursionPromise<std::vector<T>> RecursionPromise<T>::chunked(std::size_t maxChunkSize) {
+    static_assert(!std::is_void<T>::value && !std::is_reference<T>::value, "chunks require value types");
+
+    if (!Base::isValid()) throw std::logic_error("invalid promise");
+
+    using Internal = Details::ChunkGatherPromiseNodeInternal<T>;
+    auto node = std::make_shared<Internal>(maxChunkSize);
+    node->haltUpstreamBy(Base::_node);
+
+    Base::_node->chainRecursionNext([=](const Details::SharedPromiseValue<BoxVoid<T>>& v) {
+      node->gather(v);
+    }, [=](const Details::SharedPromiseValue<Void>& v) {
+      node->finishWith(v);
+    });
+
+    RecursionPromise<std::vector<T>> chunks;
+    chunks._node = node;
+    return chunks;
+  }
+
+  template<typename T>
+  RecursionPromise<T> PromiseRecursible<T>::Spawn(std::function<void(RecursionPromiseDefer<T>)>&& task, ThreadContext* &&context) {
+    static_assert(!std::is_void<T>::value, "deferred recursion requires value types");
+
+    using Internal = Details::DeferredRecursionPromiseNodeInternal<BoxVoid<T>>;
+    auto sharedContext = std::shared_ptr<ThreadContext>(std::move(context));
+
+    RecursionPromise<T> spawned;
+    auto node = std::make_shared<Internal>(sharedContext);
+    spawned._node = node;
+
+    sharedContext->scheduleToRun([node, task = std::move(task)] {
+      RecursionPromiseDefer<T> defer{ node };
+
+      try {
+        task(defer);
+      } catch (...) {
+        try {
+          defer.fail(std::current_exception());
+        } catch (...) {}
+      }
+    });
+
+    return spawned;
+  }
+
+  template<typename T>
+  template<class InputIterator>
+  RecursionPromise<T> PromiseRecursible<T>::Iterate(InputIterator begin, InputIterator end, std::size_t highWaterMark, ThreadContext* &&context) {
+    using Internal = Details::BoundedRecursionPromiseNodeInternal<BoxVoid<T>, InputIterator>;
+    auto sharedContext = std::shared_ptr<ThreadContext>(std::move(context));
+
+    RecursionPromise<T> spawned;
+    auto node = std::make_shared<Internal>(begin, end, highWaterMark, std::function<RecursionPromise<T>(std::exception_ptr)>(), sharedContext);
+    spawned._node = node;
+
+    auto runnable = std::bind(&Internal::iterate, node);
+    sharedContext->scheduleToRun(std::move(runnable));
+
+    return spawned;
+  }
+
+  template<typename T>
+  template<class InputIterator>
+  RecursionPromise<T> PromiseRecursible<T>::Iterate(InputIterator begin, InputIterator end, ThreadContext* &&context, std::false_type) {
     using Internal = Details::RecursionPromiseNodeInternal<T, Void, Void, std::true_type, InputIterator>;
     auto sharedContext = std::shared_ptr<ThreadContext>(std::move(context));
 
@@ -273,6 +583,21 @@ namespace Promise2 {
 
     return spawned;
   }
+
+  template<typename T>
+  template<class RandomAccessIterator>
+  RecursionPromise<T> PromiseRecursible<T>::Iterate(RandomAccessIterator begin, RandomAccessIterator end, ThreadContext* &&context, std::true_type) {
+    using Internal = Details::ChunkedRecursionPromiseNodeInternal<BoxVoid<T>, RandomAccessIterator>;
+    auto sharedContext = std::shared_ptr<ThreadContext>(std::move(context));
+
+    RecursionPromise<T> spawned;
+    auto node = std::make_shared<Internal>(begin, end, std::function<RecursionPromise<T>(std::exception_ptr)>(), sharedContext);
+    spawned._node = node;
+
+    Internal::schedule(node);
+
+    return spawned;
+  }
 } // Promise2
 
 #endif // PROMISE_PUBLIC_AP_ISIMPL_H
@@ -0,0 +1,222 @@
+/*
+ * Promise2
+ *
+ * Copyright (c) 2016 "0of" Magnus
+ * Licensed under the MIT license.
+ * https://github.com/0of/Promise2/blob/master/LICENSE
+ */
+#ifndef PROMISE_TRACING_H
+#define PROMISE_TRACING_H
+
+#include "../PromiseConfig.h"
+
+#if PROMISE_TRACING
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+
+namespace Promise2 {
+  namespace Details {
+
+    struct TraceEvent {
+      const char *name;
+      // chrome trace phase, `B` `E` or `i`
+      char phase;
+      std::uint64_t timestamp;
+      // the node, or the forward settled
+      const void *id;
+      // related one if any, such as the forward of the created node
+      const void *link;
+    };
+
+    //
+    // @class TraceBuffer
+    //  written by its owning thread only, every chunk is published by its size
+    //  events beyond `PROMISE_TRACE_BUFFER_SIZE` are dropped
+    //  never freed so that dumping after the thread exited is fine, the next thread takes it over
+    //
+    class TraceBuffer {
+    private:
+      struct Chunk {
+        static constexpr const std::size_t Capacity = 256;
+
+        TraceEvent events[Capacity];
+        std::atomic<std::size_t> size{ 0 };
+        std::atomic<Chunk *> next{ nullptr };
+      };
+
+    public:
+      TraceBuffer *next;
+      const std::uint32_t tid;
+      std::atomic_bool owned;
+
+    private:
+      Chunk _first;
+      // writer only
+      Chunk *_tail;
+      std::size_t _recorded;
+
+      std::atomic<std::size_t> _dropped;
+
+    public:
+      explicit TraceBuffer(std::uint32_t threadId)
+        : next{ nullptr }
+        , tid{ threadId }
+        , owned{ true }
+        , _tail{ &_first }
+        , _recorded{ 0 }
+        , _dropped{ 0 }
+      {}
+
+    public:
+      void record(const char *name, char phase, const void *id, const void *link) {
+        if (_recorded >= PROMISE_TRACE_BUFFER_SIZE) {
+          _dropped.fetch_add(1, std::memory_order_relaxed);
+          return;
+        }
+
+        auto size = _tail->size.load(std::memory_order_relaxed);
+        if (Chunk::Capacity == size) {
+          auto chunk = new Chunk;
+          _tail->next.store(chunk, std::memory_order_release);
+          _tail = chunk;
+          size = 0;
+        }
+
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        _tail->events[size] = TraceEvent{ name, phase, static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count()), id, link };
+
+        _tail->size.store(size + 1, std::memory_order_release);
+        ++_recorded;
+      }
+
+      // any thread, the events recorded meanwhile may be missed
+      template<typename Visitor>
+      void visit(Visitor&& visitor) const {
+        for (auto chunk = &_first; chunk; chunk = chunk->next.load(std::memory_order_acquire)) {
+          auto size = chunk->size.load(std::memory_order_acquire);
+          for (std::size_t i = 0; i < size; ++i) {
+            visitor(chunk->events[i]);
+          }
+        }
+      }
+
+      std::size_t dropped() const {
+        return _dropped.load(std::memory_order_relaxed);
+      }
+    };
+
+    //
+    // @class TraceBufferOwner
+    //  gives the buffer back when its thread exits
+    //
+    class TraceBufferOwner {
+    private:
+      TraceBuffer *const _buffer;
+
+    public:
+      explicit TraceBufferOwner(TraceBuffer *buffer) : _buffer{ buffer } {}
+
+      ~TraceBufferOwner() {
+        _buffer->owned.store(false, std::memory_order_release);
+      }
+
+    public:
+      TraceBuffer *operator -> () const {
+        return _buffer;
+      }
+
+    private:
+      TraceBufferOwner(const TraceBufferOwner& ) = delete;
+      TraceBufferOwner& operator = (const TraceBufferOwner& ) = delete;
+    };
+
+    class Tracer {
+    public:
+      static void record(const char *name, char phase, const void *id, const void *link = nullptr) {
+        thread_local TraceBufferOwner buffer{ registerThread() };
+        buffer->record(name, phase, id, link);
+      }
+
+      // as chrome trace event JSON, which perfetto loads as well
+      static void dump(std::ostream& out) {
+        out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+        bool first = true;
+        std::size_t dropped = 0;
+
+        for (auto buffer = head().load(std::memory_order_acquire); buffer; buffer = buffer->next) {
+          buffer->visit([&](const TraceEvent& event) {
+            out << (first ? "" : ",")
+                << "\n{\"name\":\"" << event.name << "\",\"cat\":\"promise\",\"ph\":\"" << event.phase
+                << "\",\"ts\":" << event.timestamp / 1000 << '.' << std::setw(3) << std::setfill('0') << event.timestamp % 1000 << std::setfill(' ')
+                << ",\"pid\":1,\"tid\":" << buffer->tid;
+
+            if ('i' == event.phase) out << ",\"s\":\"t\"";
+            out << ",\"args\":{\"id\":\"" << event.id << '"';
+            if (event.link) out << ",\"link\":\"" << event.link << '"';
+            out << "}}";
+
+            first = false;
+          });
+
+          dropped += buffer->dropped();
+        }
+
+        out << "\n],\"otherData\":{\"dropped\":\"" << dropped << "\"}}\n";
+      }
+
+    private:
+      static std::atomic<TraceBuffer *>& head() {
+        static std::atomic<TraceBuffer *> buffers{ nullptr };
+        return buffers;
+      }
+
+      // the buffers grow with the threads alive at once, not with every thread ever traced
+      static TraceBuffer *registerThread() {
+        static std::atomic<std::uint32_t> threads{ 0 };
+
+        auto& buffers = head();
+
+        // the events of the exited thread are kept, the ones recorded here carry on under its tid
+        for (auto buffer = buffers.load(std::memory_order_acquire); buffer; buffer = buffer->next) {
+          bool owned = false;
+          if (buffer->owned.compare_exchange_strong(owned, true, std::memory_order_acquire)) return buffer;
+        }
+
+        auto buffer = new TraceBuffer{ ++threads };
+
+        buffer->next = buffers.load(std::memory_order_relaxed);
+        while (!buffers.compare_exchange_weak(buffer->next, buffer, std::memory_order_release, std::memory_order_relaxed));
+
+        return buffer;
+      }
+    };
+  } // Details
+
+  namespace Tracing {
+    // writes the events recorded so far
+    inline void dump(std::ostream& out) {
+      Details::Tracer::dump(out);
+    }
+  } // Tracing
+}
+
+# define PROMISE_TRACE(name, id) ::Promise2::Details::Tracer::record(name, 'i', id)
+# define PROMISE_TRACE_LINK(name, id, link) ::Promise2::Details::Tracer::record(name, 'i', id, link)
+# define PROMISE_TRACE_BEGIN(name, id) ::Promise2::Details::Tracer::record(name, 'B', id)
+# define PROMISE_TRACE_END(name, id) ::Promise2::Details::Tracer::record(name, 'E', id)
+
+#else
+
+# define PROMISE_TRACE(name, id) ((void)0)
+# define PROMISE_TRACE_LINK(name, id, link) ((void)0)
+# define PROMISE_TRACE_BEGIN(name, id) ((void)0)
+# define PROMISE_TRACE_END(name, id) ((void)0)
+
+#endif // PROMISE_TRACING
+
+#endif // PROMISE_TRACING_H
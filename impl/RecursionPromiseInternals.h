@@ -8,6 +8,16 @@
 #ifndef RECURSION_PROMISE_INTERNALS_H
 #define RECURSION_PROMISE_INTERNALS_H
 
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include "../public/PromisePublicAPIs.h"
 #include "PromiseInternalsBase.h"
 
@@ -39,7 +49,7 @@ namespace Promise2 {
     protected:
       virtual void onRun(Fulfillment<ArgType, IsTask>& fulfillment) noexcept override {
         try {
-          for (; _iter != _end; ++_iter) {
+          for (; _iter != _end && !Base::isHalted(); ++_iter) {
             Base::_forward->fulfill(*_iter);
           }
         } catch (...) {
@@ -50,7 +60,381 @@ namespace Promise2 {
         Base::_finishForward->fulfill(Void{});
       }
     };
-    
+
+    template<typename Iterator, typename = void>
+    struct IsRandomAccessIterator : public std::false_type {};
+
+    template<typename Iterator>
+    struct IsRandomAccessIterator<Iterator, std::enable_if_t<std::is_base_of<std::random_access_iterator_tag,
+                                                                             typename std::iterator_traits<Iterator>::iterator_category>::value>> : public std::true_type {};
+
+    //
+    // random access range split into chunks
+    //  several workers run within the context and grab chunks shrinking with the remaining range
+    //
+    template<typename ReturnType, typename RandomAccessIterator>
+    class ChunkedRecursionPromiseNodeInternal : public RecursionPromiseNodeInternalBase<ReturnType, Void, std::true_type> {
+      using Base = RecursionPromiseNodeInternalBase<ReturnType, Void, std::true_type>;
+      using SelfType = ChunkedRecursionPromiseNodeInternal<ReturnType, RandomAccessIterator>;
+      using Distance = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+
+    public:
+      static constexpr const Distance MinChunkSize = 256;
+
+    private:
+      RandomAccessIterator _begin;
+      Distance _size;
+      Distance _workers;
+
+      std::atomic<Distance> _cursor;
+      std::atomic<Distance> _runningWorkers;
+
+      std::atomic_bool _halted;
+      std::exception_ptr _exception;
+
+    public:
+      ChunkedRecursionPromiseNodeInternal(const RandomAccessIterator& begin,
+                                          const RandomAccessIterator& end,
+                                          OnRecursionRejectFunction<ReturnType>&& onReject,
+                                          const std::shared_ptr<ThreadContext>& context)
+        : Base(std::move(onReject), context)
+        , _begin{ begin }
+        , _size{ std::max<Distance>(end - begin, 0) }
+        , _workers{ std::max<Distance>(std::min<Distance>(std::thread::hardware_concurrency(), (_size + MinChunkSize - 1) / MinChunkSize), 1) }
+        , _cursor{ 0 }
+        , _runningWorkers{ _workers }
+        , _halted{ false }
+        , _exception{ nullptr }
+      {}
+
+    public:
+      static void schedule(const std::shared_ptr<SelfType>& node) {
+        for (Distance i = 0; i < node->_workers; ++i) {
+          auto runnable = std::bind(&SelfType::work, node);
+          node->_context->scheduleToRun(std::move(runnable));
+        }
+      }
+
+    private:
+      void work() noexcept {
+        try {
+          Distance from = 0;
+          Distance count = 0;
+
+          while (!_halted && !Base::isHalted() && nextChunk(from, count)) {
+            auto iter = _begin + from;
+            for (Distance i = 0; i < count && !Base::isHalted(); ++i, ++iter) {
+              Base::_forward->fulfill(*iter);
+            }
+          }
+        } catch (...) {
+          // halt the others and keep the first exception only
+          if (!_halted.exchange(true)) {
+            _exception = std::current_exception();
+          }
+        }
+
+        // the last finished worker fires the final notification
+        if (1 == _runningWorkers.fetch_sub(1)) {
+          if (_exception) {
+            Base::_finishForward->reject(_exception);
+          } else {
+            Base::_finishForward->fulfill(Void{});
+          }
+        }
+      }
+
+      bool nextChunk(Distance& from, Distance& count) {
+        auto next = _cursor.load();
+
+        do {
+          auto remaining = _size - next;
+          if (remaining <= 0) {
+            return false;
+          }
+
+          count = std::min(remaining, std::max<Distance>(MinChunkSize, remaining / (2 * _workers)));
+        } while (!_cursor.compare_exchange_weak(next, next + count));
+
+        from = next;
+        return true;
+      }
+    };
+
+    template<typename ReturnType, typename RandomAccessIterator>
+    constexpr const typename ChunkedRecursionPromiseNodeInternal<ReturnType, RandomAccessIterator>::Distance ChunkedRecursionPromiseNodeInternal<ReturnType, RandomAccessIterator>::MinChunkSize;
+
+    //
+    // gathers the values of the previous recursion into chunks
+    //  runs inline where the previous one notifies, chunks keep the notified order
+    //
+    template<typename T>
+    class ChunkGatherPromiseNodeInternal : public RecursionPromiseNodeInternalBase<std::vector<T>, Void, std::true_type> {
+      using Base = RecursionPromiseNodeInternalBase<std::vector<T>, Void, std::true_type>;
+
+    public:
+      // upper bound of the reserved capacity
+      static constexpr const std::size_t MaxReservedSize = 4096;
+
+    private:
+      std::mutex _mutex;
+      std::vector<T> _chunk;
+      const std::size_t _maxChunkSize;
+
+    public:
+      explicit ChunkGatherPromiseNodeInternal(std::size_t maxChunkSize)
+        : Base(OnRecursionRejectFunction<std::vector<T>>{}, nullptr)
+        , _chunk{}
+        , _maxChunkSize{ std::max<std::size_t>(maxChunkSize, 1) } {
+        _chunk.reserve(std::min(_maxChunkSize, MaxReservedSize));
+      }
+
+    public:
+      void gather(const SharedPromiseValue<BoxVoid<T>>& value) {
+        std::lock_guard<std::mutex> _{ _mutex };
+
+        if (value->isExceptionCase()) {
+          // values gathered before the exception are delivered first
+          flush();
+          Base::_forward->reject(value->fetchException());
+          return;
+        }
+
+        _chunk.push_back(value->template getValue<const T&>());
+
+        if (_chunk.size() >= _maxChunkSize) {
+          flush();
+        }
+      }
+
+      void finishWith(const SharedPromiseValue<Void>& value) {
+        {
+          std::lock_guard<std::mutex> _{ _mutex };
+          flush();
+        }
+
+        Base::finish(value);
+      }
+
+    private:
+      void flush() {
+        if (_chunk.empty()) return;
+
+        Base::_forward->fulfill(std::move(_chunk));
+
+        _chunk = std::vector<T>{};
+        _chunk.reserve(std::min(_maxChunkSize, MaxReservedSize));
+      }
+    };
+
+    template<typename T>
+    constexpr const std::size_t ChunkGatherPromiseNodeInternal<T>::MaxReservedSize;
+
+    //
+    // ordered thenable
+    //  values are numbered in the notified order and the results are emitted through a reorder buffer
+    //  the ready results are emitted outside the lock by one thread at a time
+    //  values beyond the window wait unscheduled, which bounds the buffer
+    //  a recovery recursion returned by `onReject` takes the slot and streams its values as they settle
+    //
+    template<typename ReturnType, typename ArgType, typename ConvertibleArgType>
+    class OrderedPromiseNodeInternal : public RecursionPromiseNodeInternalBase<ReturnType, ArgType, std::false_type> {
+      using Base = RecursionPromiseNodeInternalBase<ReturnType, ArgType, std::false_type>;
+      using SelfType = OrderedPromiseNodeInternal<ReturnType, ArgType, ConvertibleArgType>;
+
+      static_assert(!std::is_reference<ReturnType>::value, "ordered thenable requires value types");
+
+    private:
+      // neither set once recovered
+      struct Result {
+        std::unique_ptr<ReturnType> value;
+        std::exception_ptr exception;
+      };
+
+      using Runnables = std::vector<std::function<void()>>;
+
+    private:
+      std::function<ReturnType(ConvertibleArgType)> _onFulfill;
+
+      std::mutex _mutex;
+      const std::uint64_t _window;
+      // next sequence number to assign
+      std::uint64_t _assigned;
+      // next sequence number to collect from the reorder buffer
+      std::uint64_t _collected;
+      // count of the emitted ones
+      std::uint64_t _emitted;
+      std::map<std::uint64_t, Result> _reordered;
+      // collected in order, waiting to be emitted
+      std::vector<Result> _ready;
+      bool _emitting;
+      std::deque<SharedPromiseValue<ArgType>> _waiting;
+      SharedPromiseValue<Void> _finished;
+
+    public:
+      OrderedPromiseNodeInternal(std::function<ReturnType(ConvertibleArgType)>&& onFulfill,
+                                 OnRecursionRejectFunction<ReturnType>&& onReject,
+                                 const std::shared_ptr<ThreadContext>& context,
+                                 std::size_t window)
+        : Base(std::move(onReject), context)
+        , _onFulfill{ std::move(onFulfill) }
+        , _window{ std::max<std::uint64_t>(window, 1) }
+        , _assigned{ 0 }
+        , _collected{ 0 }
+        , _emitted{ 0 }
+        , _reordered{}
+        , _ready{}
+        , _emitting{ false }
+        , _waiting{}
+        , _finished{}
+      {}
+
+    public:
+      // inline where the previous one notifies
+      static void dispatch(const std::shared_ptr<SelfType>& node, const SharedPromiseValue<ArgType>& value) {
+        std::function<void()> runnable;
+        {
+          std::lock_guard<std::mutex> _{ node->_mutex };
+
+          if (node->_assigned - node->_emitted < node->_window) {
+            runnable = assign(node, value);
+          } else {
+            node->_waiting.push_back(value);
+          }
+        }
+
+        // an inline context runs it right away, which takes the lock again
+        if (runnable) {
+          node->_context->scheduleToRun(std::move(runnable));
+        }
+      }
+
+      // the finish notification is held till every value has been emitted
+      static void finishWith(const std::shared_ptr<SelfType>& node, const SharedPromiseValue<Void>& value) {
+        {
+          std::lock_guard<std::mutex> _{ node->_mutex };
+
+          if (!node->isDrained()) {
+            node->_finished = value;
+            return;
+          }
+        }
+
+        node->finish(value);
+      }
+
+    private:
+      // within the lock, scheduled once unlocked
+      static std::function<void()> assign(const std::shared_ptr<SelfType>& node, const SharedPromiseValue<ArgType>& value) {
+        return std::bind(&SelfType::runOrdered, node, value, node->_assigned++);
+      }
+
+      static void runOrdered(const std::shared_ptr<SelfType>& node, const SharedPromiseValue<ArgType>& value, std::uint64_t sequence) {
+        Result result = node->run(value);
+
+        std::unique_lock<std::mutex> lock{ node->_mutex };
+        node->_reordered.emplace(sequence, std::move(result));
+        node->collect();
+
+        // the emitting one picks up the collected results
+        if (node->_emitting) return;
+
+        node->_emitting = true;
+        while (!node->_ready.empty()) {
+          auto ready = std::move(node->_ready);
+          node->_ready.clear();
+
+          lock.unlock();
+          for (auto& each : ready) {
+            node->emit(each);
+          }
+          lock.lock();
+
+          node->_emitted += ready.size();
+        }
+        node->_emitting = false;
+
+        // the window slides
+        Runnables runnables;
+        while (!node->_waiting.empty() && node->_assigned - node->_emitted < node->_window) {
+          runnables.push_back(assign(node, node->_waiting.front()));
+          node->_waiting.pop_front();
+        }
+
+        SharedPromiseValue<Void> finished;
+        if (node->_finished && node->isDrained()) {
+          finished = std::move(node->_finished);
+        }
+
+        lock.unlock();
+
+        for (auto& runnable : runnables) {
+          node->_context->scheduleToRun(std::move(runnable));
+        }
+
+        if (finished) {
+          node->finish(finished);
+        }
+      }
+
+    private:
+      Result run(const SharedPromiseValue<ArgType>& value) noexcept {
+        Result result;
+
+        Fulfillment<ArgType, std::false_type> fulfillment { value };
+        try {
+          fulfillment.guard();
+        } catch (...) {
+          result.exception = std::current_exception();
+
+          if (Base::_onReject) {
+            try {
+              // chain the returned recursion only if valid, the same as `then`
+              auto p = Base::_onReject(result.exception);
+              if (p.isValid()) {
+                Base::chainRecovery(p.internal());
+                result.exception = nullptr;
+              }
+            } catch (...) {
+              result.exception = std::current_exception();
+            }
+          }
+
+          return result;
+        }
+
+        try {
+          result.value = std::make_unique<ReturnType>(_onFulfill(fulfillment.template get<ConvertibleArgType>()));
+        } catch (...) {
+          result.exception = std::current_exception();
+        }
+
+        return result;
+      }
+
+      // within the lock
+      void collect() {
+        for (auto front = _reordered.begin(); front != _reordered.end() && front->first == _collected; front = _reordered.begin()) {
+          _ready.push_back(std::move(front->second));
+          _reordered.erase(front);
+          ++_collected;
+        }
+      }
+
+      // out of the lock
+      void emit(Result& result) {
+        if (result.value) {
+          Base::_forward->fulfill(std::move(*result.value));
+        } else if (result.exception) {
+          Base::_forward->reject(result.exception);
+        }
+      }
+
+      // within the lock
+      bool isDrained() const {
+        return _waiting.empty() && _assigned == _emitted;
+      }
+    };
   }
 }
 
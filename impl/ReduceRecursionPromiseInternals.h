@@ -0,0 +1,146 @@
+/*
+ * Promise2
+ *
+ * Copyright (c) 2016 "0of" Magnus
+ * Licensed under the MIT license.
+ * https://github.com/0of/Promise2/blob/master/LICENSE
+ */
+#ifndef REDUCE_RECURSION_PROMISE_INTERNALS_H
+#define REDUCE_RECURSION_PROMISE_INTERNALS_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+#include "../public/PromisePublicAPIs.h"
+#include "PromiseInternalsBase.h"
+
+namespace Promise2 {
+  namespace Details {
+
+    //
+    // reduce PromiseNodeInternal
+    //  every notifying thread folds into its own partial accumulator inline, found through its thread cache
+    //  the partials are merged within the context once the recursion finished
+    //  every value notified happens before the finish, the scheduled ones are waited for by the finish barrier
+    //
+    template<typename Acc, typename T>
+    class ReducePromiseNodeInternal : public PromiseNodeInternalBase<Acc, Void, std::true_type> {
+      using Base = PromiseNodeInternalBase<Acc, Void, std::true_type>;
+      using SelfType = ReducePromiseNodeInternal<Acc, T>;
+
+    public:
+      // partials cached by each thread, stale ones are dropped beyond this
+      static constexpr const std::size_t MaxCachedPartials = 16;
+
+    private:
+      // the partial of the node most recently accumulated by the current thread
+      struct PartialCache {
+        std::uint64_t generation = 0;
+        Acc *partial = nullptr;
+        std::unordered_map<std::uint64_t, Acc *> others;
+      };
+
+    private:
+      const Acc _identity;
+      std::function<Acc(Acc, const T&)> _combine;
+      std::function<Acc(Acc, Acc)> _merge;
+
+      // identifies the node in the thread caches, never reused
+      const std::uint64_t _generation;
+
+      // guards the registration only, each partial is written by its own thread
+      std::mutex _mutex;
+      std::deque<Acc> _partials;
+      std::exception_ptr _exception;
+
+    public:
+      ReducePromiseNodeInternal(const Acc& identity,
+                                std::function<Acc(Acc, const T&)>&& combine,
+                                std::function<Acc(Acc, Acc)>&& merge,
+                                const std::shared_ptr<ThreadContext>& context)
+        : Base(OnRejectFunction<Acc>{}, context)
+        , _identity{ identity }
+        , _combine{ std::move(combine) }
+        , _merge{ std::move(merge) }
+        , _generation{ ++generations() }
+        , _partials{}
+        , _exception{}
+      {}
+
+    public:
+      // inline where the recursion notifies, no locks once the thread registered its partial
+      void accumulate(const SharedPromiseValue<T>& value) noexcept {
+        try {
+          value->accessGuard();
+
+          Acc& partial = current();
+          partial = _combine(std::move(partial), value->template getValue<const T&>());
+        } catch (...) {
+          std::lock_guard<std::mutex> _{ _mutex };
+          if (!_exception) _exception = std::current_exception();
+        }
+      }
+
+      // within the context, after every accumulation
+      void merge(const SharedPromiseValue<Void>& finished) noexcept {
+        try {
+          finished->accessGuard();
+
+          std::lock_guard<std::mutex> _{ _mutex };
+          if (_exception) std::rethrow_exception(_exception);
+
+          // in the registered order, which differs run by run
+          Acc result = _identity;
+          for (auto& partial : _partials) {
+            result = _merge(std::move(result), std::move(partial));
+          }
+
+          Base::_forward->fulfill(std::move(result));
+        } catch (...) {
+          Base::_forward->reject(std::current_exception());
+        }
+      }
+
+    private:
+      static std::atomic<std::uint64_t>& generations() {
+        static std::atomic<std::uint64_t> generations{ 0 };
+        return generations;
+      }
+
+      Acc& current() {
+        static thread_local PartialCache cache;
+
+        if (cache.generation == _generation) {
+          return *cache.partial;
+        }
+
+        auto found = cache.others.find(_generation);
+        if (found == cache.others.end()) {
+          if (cache.others.size() >= MaxCachedPartials) {
+            // another partial would be registered if the node comes again
+            cache.others.clear();
+          }
+
+          std::lock_guard<std::mutex> _{ _mutex };
+          // elements of a deque stay put when appended
+          _partials.emplace_back(_identity);
+          found = cache.others.emplace(_generation, &_partials.back()).first;
+        }
+
+        cache.generation = _generation;
+        cache.partial = found->second;
+
+        return *cache.partial;
+      }
+    };
+
+    template<typename Acc, typename T>
+    constexpr const std::size_t ReducePromiseNodeInternal<Acc, T>::MaxCachedPartials;
+  } // Details
+}
+
+#endif // REDUCE_RECURSION_PROMISE_INTERNALS_H
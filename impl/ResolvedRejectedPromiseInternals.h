@@ -16,21 +16,23 @@ namespace Promise2 {
     // Resolved/Rejected promise internals
     //
     template<typename ReturnType>
-    class ResolvedRejectedPromiseInternals : public PromiseNode<ReturnType> {
+    class ResolvedRejectedPromiseInternals : public PromiseNode<ReturnType>, private LiveNode {
     private:
       SharedPromiseValue<ReturnType> _promiseValue;
 
     public:
       template<typename ValueType>
       explicit ResolvedRejectedPromiseInternals(ValueType&& v)
-        : _promiseValue{ std::make_shared<typename SharedPromiseValue<ReturnType>::element_type>() } {
+        : LiveNode{ NodeKind::Resolved }
+        , _promiseValue{ std::make_shared<typename SharedPromiseValue<ReturnType>::element_type>() } {
         // fulfilled the value
         _promiseValue->setValue(std::forward<ValueType>(v));
       }
 
       // exception
       explicit ResolvedRejectedPromiseInternals(std::exception_ptr e)
-        : _promiseValue{ std::make_shared<typename SharedPromiseValue<ReturnType>::element_type>() } {
+        : LiveNode{ NodeKind::Resolved }
+        , _promiseValue{ std::make_shared<typename SharedPromiseValue<ReturnType>::element_type>() } {
         // rejected
         _promiseValue->setException(e);
       }
@@ -61,6 +63,13 @@ namespace Promise2 {
       virtual bool isRejected() const override {
         return _promiseValue->hasAssigned() && _promiseValue->isExceptionCase();
       }
+
+      // always settled
+      virtual void wait() const override {}
+
+      virtual bool waitFor(std::chrono::nanoseconds) const override {
+        return true;
+      }
     }; 
   } // Details
 }
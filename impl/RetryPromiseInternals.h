@@ -0,0 +1,107 @@
+/*
+ * Promise2
+ *
+ * Copyright (c) 2016 "0of" Magnus
+ * Licensed under the MIT license.
+ * https://github.com/0of/Promise2/blob/master/LICENSE
+ */
+#ifndef RETRY_PROMISE_INTERNALS_H
+#define RETRY_PROMISE_INTERNALS_H
+
+#include <algorithm>
+#include <random>
+
+#include "../public/PromisePublicAPIs.h"
+#include "PromiseInternalsBase.h"
+#include "TimerQueue.h"
+
+namespace Promise2 {
+  namespace Details {
+    //
+    // retry PromiseNodeInternal
+    //  every attempt settles into the same forward, delays are served by the timer queue
+    //
+    template<typename T>
+    class RetryPromiseNodeInternal : public PromiseNodeInternalBase<BoxVoid<T>, Void, std::true_type> {
+      using Base = PromiseNodeInternalBase<BoxVoid<T>, Void, std::true_type>;
+      using SelfType = RetryPromiseNodeInternal<T>;
+
+    private:
+      std::function<Promise<T>()> _taskFactory;
+      RetryPolicy _policy;
+
+      // attempts are serialized, no guard required
+      std::uint32_t _attempts;
+      std::chrono::nanoseconds _delay;
+      std::minstd_rand _random;
+
+    public:
+      RetryPromiseNodeInternal(std::function<Promise<T>()>&& taskFactory,
+                               const RetryPolicy& policy,
+                               const std::shared_ptr<ThreadContext>& context)
+        : Base(OnRejectFunction<BoxVoid<T>>{}, context)
+        , _taskFactory{ std::move(taskFactory) }
+        , _policy(policy)
+        , _attempts{ 0 }
+        , _delay{ policy.initialDelay }
+        , _random{ static_cast<std::minstd_rand::result_type>(reinterpret_cast<std::uintptr_t>(this)) }
+      {}
+
+    public:
+      // run within the context
+      static void attempt(const std::shared_ptr<SelfType>& node) {
+        ++node->_attempts;
+
+        try {
+          auto promise = node->_taskFactory();
+          if (!promise.isValid()) throw std::logic_error("invalid promise");
+
+          promise.internal()->chainNext([node](const SharedPromiseValue<BoxVoid<T>>& v) {
+            if (v->isExceptionCase()) {
+              retryOrReject(node, v->fetchException());
+            } else {
+              node->_forward->fulfill(v->template getValue<BoxVoid<T>>());
+            }
+          });
+        } catch (...) {
+          retryOrReject(node, std::current_exception());
+        }
+      }
+
+    private:
+      static void retryOrReject(const std::shared_ptr<SelfType>& node, std::exception_ptr e) {
+        try {
+          auto& policy = node->_policy;
+          if (node->_attempts >= policy.maxAttempts || (policy.retryIf && !policy.retryIf(e))) {
+            node->_forward->reject(e);
+            return;
+          }
+
+          TimerQueue::shared().schedule(node->nextDelay(), [node] {
+            auto runnable = std::bind(&SelfType::attempt, node);
+            node->_context->scheduleToRun(std::move(runnable));
+          });
+        } catch (...) {
+          node->_forward->reject(std::current_exception());
+        }
+      }
+
+      // exponential backoff with jitter in [(1 - jitter) * delay, delay]
+      std::chrono::nanoseconds nextDelay() {
+        auto delay = _delay;
+
+        auto backoff = std::chrono::duration<double, std::nano>(_delay) * _policy.multiplier;
+        _delay = std::min(std::chrono::duration_cast<std::chrono::nanoseconds>(backoff), _policy.maxDelay);
+
+        if (_policy.jitter > 0) {
+          std::uniform_real_distribution<double> distribution{ 1.0 - std::min(_policy.jitter, 1.0), 1.0 };
+          delay = std::chrono::duration_cast<std::chrono::nanoseconds>(delay * distribution(_random));
+        }
+
+        return delay;
+      }
+    };
+  } // Details
+}
+
+#endif // RETRY_PROMISE_INTERNALS_H
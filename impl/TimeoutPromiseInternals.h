@@ -0,0 +1,73 @@
+/*
+ * Promise2
+ *
+ * Copyright (c) 2016 "0of" Magnus
+ * Licensed under the MIT license.
+ * https://github.com/0of/Promise2/blob/master/LICENSE
+ */
+#ifndef TIMEOUT_PROMISE_INTERNALS_H
+#define TIMEOUT_PROMISE_INTERNALS_H
+
+#include "../public/PromisePublicAPIs.h"
+#include "PromiseInternalsBase.h"
+#include "TimerQueue.h"
+
+namespace Promise2 {
+  namespace Details {
+    //
+    // timeout PromiseNodeInternal
+    //  forwards the source value unless the timer fires first
+    //
+    template<typename ReturnType>
+    class TimeoutPromiseNodeInternal : public PromiseNodeInternalBase<ReturnType, ReturnType, std::false_type> {
+      using Base = PromiseNodeInternalBase<ReturnType, ReturnType, std::false_type>;
+      using SelfType = TimeoutPromiseNodeInternal<ReturnType>;
+
+    private:
+      std::atomic_flag _settled;
+      TimerQueue::Key _timer;
+
+    public:
+      explicit TimeoutPromiseNodeInternal(const std::shared_ptr<ThreadContext>& context)
+        : Base(OnRejectFunction<ReturnType>{}, context)
+        , _settled{ ATOMIC_FLAG_INIT }
+        , _timer{}
+      {}
+
+    public:
+      // the pending timer keeps the node alive till it fires or gets cancelled
+      static void arm(const std::shared_ptr<SelfType>& node, TimerQueue::Clock::duration timeout) {
+        node->_timer = TimerQueue::shared().schedule(timeout, [node] {
+          if (node->acquire()) {
+            node->_context->scheduleToRun(std::bind(&SelfType::expire, node));
+          }
+        });
+      }
+
+      // either the timer or the source settles the node, never both
+      bool acquire() {
+        return !_settled.test_and_set();
+      }
+
+      // source settled first
+      void disarm() {
+        TimerQueue::shared().cancel(_timer);
+      }
+
+      void expire() noexcept {
+        Base::_forward->reject(std::make_exception_ptr(TimeoutException{}));
+      }
+
+    protected:
+      virtual void onRun(Fulfillment<ReturnType, std::false_type>& fulfillment) noexcept override {
+        try {
+          Base::_forward->fulfill(fulfillment.template get<ReturnType>());
+        } catch (...) {
+          Base::_forward->reject(std::current_exception());
+        }
+      }
+    };
+  } // Details
+}
+
+#endif // TIMEOUT_PROMISE_INTERNALS_H
@@ -0,0 +1,143 @@
+/*
+ * Promise2
+ *
+ * Copyright (c) 2016 "0of" Magnus
+ * Licensed under the MIT license.
+ * https://github.com/0of/Promise2/blob/master/LICENSE
+ */
+#ifndef TIMER_QUEUE_H
+#define TIMER_QUEUE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace Promise2 {
+  namespace Details {
+
+    //
+    // @class TimerQueue
+    //  all pending timers share one lazily started thread, ordered by deadline
+    //  the thread only sleeps until the nearest deadline, never per timer
+    //
+    class TimerQueue {
+    public:
+      using Clock = std::chrono::steady_clock;
+      using Task = std::function<void()>;
+      // (deadline, sequence) keeps timers with the same deadline distinct
+      using Key = std::pair<Clock::time_point, std::uint64_t>;
+
+    public:
+      static TimerQueue& shared() {
+        static TimerQueue queue;
+        return queue;
+      }
+
+    private:
+      std::mutex _mutex;
+      std::condition_variable _condition;
+      std::map<Key, Task> _tasks;
+      std::uint64_t _sequence;
+      bool _quit;
+      std::thread _thread;
+
+    public:
+      TimerQueue()
+        : _sequence{ 0 }
+        , _quit{ false }
+      {}
+
+      ~TimerQueue() {
+        {
+          std::lock_guard<std::mutex> _{ _mutex };
+          _quit = true;
+        }
+
+        _condition.notify_one();
+
+        if (_thread.joinable()) {
+          _thread.join();
+        }
+      }
+
+    public:
+      // task is invoked on the timer thread and must not block
+      Key schedule(Clock::duration delay, Task&& task) {
+        std::lock_guard<std::mutex> _{ _mutex };
+
+        Key key{ Clock::now() + delay, ++_sequence };
+        bool nearest = _tasks.empty() || key < _tasks.begin()->first;
+
+        _tasks.emplace(key, std::move(task));
+
+        if (!_thread.joinable()) {
+          _thread = std::thread{ &TimerQueue::loop, this };
+        } else if (nearest) {
+          _condition.notify_one();
+        }
+
+        return key;
+      }
+
+      // returns false if the task has already been fired or cancelled
+      bool cancel(const Key& key) {
+        Task cancelled;
+        {
+          std::lock_guard<std::mutex> _{ _mutex };
+
+          auto found = _tasks.find(key);
+          if (found == _tasks.end()) {
+            return false;
+          }
+
+          // destruct the captures outside the critical section
+          cancelled = std::move(found->second);
+          _tasks.erase(found);
+        }
+
+        return true;
+      }
+
+    private:
+      void loop() {
+        std::unique_lock<std::mutex> lock{ _mutex };
+
+        while (!_quit) {
+          if (_tasks.empty()) {
+            _condition.wait(lock);
+            continue;
+          }
+
+          auto nearest = _tasks.begin();
+          if (Clock::now() < nearest->first.first) {
+            _condition.wait_until(lock, nearest->first.first);
+            continue;
+          }
+
+          auto task = std::move(nearest->second);
+          _tasks.erase(nearest);
+
+          lock.unlock();
+
+          try {
+            task();
+          } catch (...) {}
+
+          task = nullptr;
+          lock.lock();
+        }
+      }
+
+    private:
+      TimerQueue(const TimerQueue&) = delete;
+      TimerQueue& operator = (const TimerQueue&) = delete;
+    };
+  } // Details
+}
+
+#endif // TIMER_QUEUE_H
@@ -9,12 +9,16 @@
 #ifndef GENERAL_PROMISE_VALUE_H
 #define GENERAL_PROMISE_VALUE_H
 
+#include <memory>
+#include <new>
+#include <type_traits>
+
 #include "PromiseValueBase.h"
 
 namespace Promise2 {
   namespace Details {
 
-    template<typename T>
+    template<typename T, bool IsInline = std::is_trivially_copyable<T>::value>
     class PromiseValue : public PromiseValueBase {
     private:
       std::unique_ptr<T> _valuePointer;
@@ -37,6 +41,30 @@ namespace Promise2 {
       }
     };
 
+    // trivially copyable values stored within, no extra allocation
+    template<typename T>
+    class PromiseValue<T, true> : public PromiseValueBase {
+    private:
+      std::aligned_storage_t<sizeof(T), alignof(T)> _storage;
+
+    public:
+      template<typename ValueType>
+      void setValue(ValueType&& v) {
+        if (_assignGuard.test_and_set()) {
+          // already assigned or is assigning
+          throw std::logic_error("promise duplicated assignments");
+        }
+
+        new (&_storage) T(std::forward<ValueType>(v));
+        _hasAssigned = true;
+      }
+
+      template<typename ValueType>
+      ValueType getValue() {
+        return static_cast<ValueType>(*reinterpret_cast<T *>(&_storage));
+      }
+    };
+
     template<typename T>
     class PromisePointerValue : public PromiseValueBase {
     private:
@@ -0,0 +1,181 @@
+/*
+ * Promise2
+ *
+ * Copyright (c) 2016 "0of" Magnus
+ * Licensed under the MIT license.
+ * https://github.com/0of/Promise2/blob/master/LICENSE
+ */
+
+#ifndef PROMISE_VALUE_RING_H
+#define PROMISE_VALUE_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace Promise2 {
+  namespace Details {
+
+    //
+    // @class PromiseValueRing
+    //  contiguous cache-line aligned slots handed out in order and reused across the stream
+    //  one producer at a time, the others and the ones finding the next slot still held fall back to the heap
+    //  any thread may release the slot it holds
+    //
+    class PromiseValueRing {
+    public:
+      static constexpr const std::size_t CacheLineSize = 64;
+
+    private:
+      // the payload is aligned as the header size
+      static constexpr const std::size_t HeaderSize = alignof(std::max_align_t);
+
+      struct SlotHeader {
+        std::atomic_bool held;
+      };
+
+    private:
+      const std::size_t _slotSize;
+      // power of two
+      const std::size_t _capacity;
+
+      void *_memory;
+      unsigned char *_slots;
+
+      std::atomic_flag _producing;
+      // producer only
+      std::size_t _next;
+
+      // the owner and every living allocation
+      std::atomic<std::size_t> _refs;
+
+    public:
+      PromiseValueRing(std::size_t payloadSize, std::size_t capacity)
+        : _slotSize{ (HeaderSize + payloadSize + CacheLineSize - 1) / CacheLineSize * CacheLineSize }
+        , _capacity{ roundUp(capacity) }
+        , _memory{ ::operator new(_slotSize * _capacity + CacheLineSize) }
+        , _slots{ nullptr }
+        , _next{ 0 }
+        , _refs{ 1 } {
+        auto address = reinterpret_cast<std::uintptr_t>(_memory);
+        _slots = static_cast<unsigned char *>(_memory) + (CacheLineSize - address % CacheLineSize) % CacheLineSize;
+
+        for (std::size_t i = 0; i < _capacity; ++i) {
+          auto header = new (_slots + i * _slotSize) SlotHeader;
+          header->held.store(false, std::memory_order_relaxed);
+        }
+
+        _producing.clear();
+      }
+
+      ~PromiseValueRing() {
+        ::operator delete(_memory);
+      }
+
+    public:
+      // `nullptr` if the caller should allocate elsewhere
+      void *acquire(std::size_t size, std::size_t alignment) {
+        if (size > _slotSize - HeaderSize || alignment > HeaderSize) return nullptr;
+        if (_producing.test_and_set(std::memory_order_acquire)) return nullptr;
+
+        void *payload = nullptr;
+
+        auto slot = _slots + _next * _slotSize;
+        auto header = reinterpret_cast<SlotHeader *>(slot);
+
+        // still held by a slow consumer, the ring is full
+        if (!header->held.load(std::memory_order_acquire)) {
+          header->held.store(true, std::memory_order_relaxed);
+          _next = (_next + 1) & (_capacity - 1);
+
+          payload = slot + HeaderSize;
+        }
+
+        _producing.clear(std::memory_order_release);
+        return payload;
+      }
+
+      // false if not acquired from the ring
+      bool release(void *payload) {
+        auto bytes = static_cast<unsigned char *>(payload);
+        if (bytes < _slots || bytes >= _slots + _slotSize * _capacity) return false;
+
+        reinterpret_cast<SlotHeader *>(bytes - HeaderSize)->held.store(false, std::memory_order_release);
+        return true;
+      }
+
+      void retain() {
+        _refs.fetch_add(1, std::memory_order_relaxed);
+      }
+
+      // the ring is deleted once the owner and every allocation gone
+      void unref() {
+        if (1 == _refs.fetch_sub(1, std::memory_order_acq_rel)) {
+          delete this;
+        }
+      }
+
+    private:
+      static std::size_t roundUp(std::size_t capacity) {
+        std::size_t rounded = 1;
+        while (rounded < capacity) rounded <<= 1;
+        return rounded;
+      }
+
+    private:
+      PromiseValueRing(const PromiseValueRing&) = delete;
+      PromiseValueRing& operator = (const PromiseValueRing&) = delete;
+    };
+
+    //
+    // allocates the shared values from the ring, the heap otherwise
+    //
+    template<typename T>
+    class PromiseValueRingAllocator {
+    public:
+      using value_type = T;
+
+    public:
+      PromiseValueRing *ring;
+
+    public:
+      explicit PromiseValueRingAllocator(PromiseValueRing *r)
+        : ring{ r }
+      {}
+
+      template<typename K>
+      PromiseValueRingAllocator(const PromiseValueRingAllocator<K>& allocator)
+        : ring{ allocator.ring }
+      {}
+
+    public:
+      T *allocate(std::size_t n) {
+        auto payload = ring->acquire(n * sizeof(T), alignof(T));
+        if (!payload) {
+          payload = ::operator new(n * sizeof(T));
+        }
+
+        ring->retain();
+        return static_cast<T *>(payload);
+      }
+
+      void deallocate(T *p, std::size_t) {
+        if (!ring->release(p)) {
+          ::operator delete(p);
+        }
+
+        ring->unref();
+      }
+
+    public:
+      template<typename K>
+      bool operator == (const PromiseValueRingAllocator<K>& allocator) const { return ring == allocator.ring; }
+
+      template<typename K>
+      bool operator != (const PromiseValueRingAllocator<K>& allocator) const { return ring != allocator.ring; }
+    };
+  }
+}
+
+#endif // PROMISE_VALUE_RING_H
@@ -0,0 +1,193 @@
+/*
+ * Promise2
+ *
+ * Copyright (c) 2016 "0of" Magnus
+ * Licensed under the MIT license.
+ * https://github.com/0of/Promise2/blob/master/LICENSE
+ */
+
+#ifndef PROMISE_LABEL_H
+#define PROMISE_LABEL_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <time.h>
+
+namespace Promise2 {
+  namespace Details {
+
+    struct LabelStats {
+      const std::string name;
+
+      std::atomic<std::uint64_t> invocations{ 0 };
+      std::atomic<std::uint64_t> cpuNanoseconds{ 0 };
+      std::atomic<std::uint64_t> wallNanoseconds{ 0 };
+      std::atomic<std::uint64_t> maxNanoseconds{ 0 };
+
+      explicit LabelStats(const std::string& labelName)
+        : name{ labelName }
+      {}
+    };
+
+    //
+    // @class LabelRegistry
+    //  the stats are never freed, a label resolves its name once
+    //
+    class LabelRegistry {
+    private:
+      std::mutex _mutex;
+      std::vector<std::unique_ptr<LabelStats>> _stats;
+
+    public:
+      static LabelRegistry& global() {
+        static LabelRegistry registry;
+        return registry;
+      }
+
+    public:
+      LabelStats *resolve(const std::string& name) {
+        std::lock_guard<std::mutex> _{ _mutex };
+
+        for (auto& stats : _stats) {
+          if (name == stats->name) return stats.get();
+        }
+
+        _stats.emplace_back(new LabelStats{ name });
+        return _stats.back().get();
+      }
+
+      template<typename Visitor>
+      void visit(Visitor&& visitor) {
+        std::lock_guard<std::mutex> _{ _mutex };
+
+        for (auto& stats : _stats) {
+          visitor(*stats);
+        }
+      }
+    };
+
+    // the CPU time consumed by the calling thread, wall clock if not supported such as on Windows
+    inline std::uint64_t threadCPUTime() {
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+      timespec now;
+      if (0 == ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now)) {
+        return static_cast<std::uint64_t>(now.tv_sec) * 1000000000ull + static_cast<std::uint64_t>(now.tv_nsec);
+      }
+#endif
+      return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // the label of the invocation running on the calling thread, read by the pool watchdog
+    inline std::atomic<LabelStats *>& currentLabel() {
+      static thread_local std::atomic<LabelStats *> label{ nullptr };
+      return label;
+    }
+
+    // measures one invocation, recorded even if thrown
+    class LabelScope {
+    private:
+      LabelStats *_stats;
+      // labelled invocations may run inline within another
+      LabelStats *_outer;
+
+      // the CPU clock read within the wall clock
+      std::chrono::steady_clock::time_point _wall;
+      std::uint64_t _cpu;
+
+    public:
+      explicit LabelScope(LabelStats *stats)
+        : _stats{ stats }
+        , _outer{ currentLabel().exchange(stats, std::memory_order_release) }
+        , _wall{ std::chrono::steady_clock::now() }
+        , _cpu{ threadCPUTime() }
+      {}
+
+      ~LabelScope() {
+        auto cpu = threadCPUTime() - _cpu;
+        auto wall = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _wall).count());
+
+        _stats->invocations.fetch_add(1, std::memory_order_relaxed);
+        _stats->cpuNanoseconds.fetch_add(cpu, std::memory_order_relaxed);
+        _stats->wallNanoseconds.fetch_add(wall, std::memory_order_relaxed);
+
+        auto max = _stats->maxNanoseconds.load(std::memory_order_relaxed);
+        while (max < wall && !_stats->maxNanoseconds.compare_exchange_weak(max, wall, std::memory_order_relaxed));
+
+        currentLabel().store(_outer, std::memory_order_release);
+      }
+
+    private:
+      LabelScope(const LabelScope& ) = delete;
+      LabelScope& operator = (const LabelScope& ) = delete;
+    };
+  } // Details
+
+  //
+  // @class Label
+  //  names a callback site, passed as the last argument of `New`, `then`, `caught` and `Iterate`
+  //  resolve once and reuse it on the hot paths, the name lookup takes a lock
+  //
+  class Label {
+  private:
+    Details::LabelStats *_stats;
+
+  public:
+    Label(const char *name)
+      : _stats{ Details::LabelRegistry::global().resolve(name) }
+    {}
+
+    Label(const std::string& name)
+      : _stats{ Details::LabelRegistry::global().resolve(name) }
+    {}
+
+  public:
+    Details::LabelStats *stats() const { return _stats; }
+
+    // `fn` measured under this label whenever invoked
+    template<typename Return, typename... Args>
+    std::function<Return(Args...)> wrap(std::function<Return(Args...)>&& fn) const {
+      return [stats = _stats, fn = std::move(fn)](Args... args) -> Return {
+        Details::LabelScope _{ stats };
+        return fn(std::forward<Args>(args)...);
+      };
+    }
+  };
+
+  namespace Labels {
+    struct LabelSnapshot {
+      std::string name;
+
+      std::uint64_t invocations;
+      // consumed by the invoking threads
+      std::uint64_t cpuNanoseconds;
+      std::uint64_t wallNanoseconds;
+      // the slowest invocation in wall time
+      std::uint64_t maxNanoseconds;
+    };
+
+    // every label resolved so far
+    inline std::vector<LabelSnapshot> snapshot() {
+      std::vector<LabelSnapshot> snapshots;
+
+      Details::LabelRegistry::global().visit([&](const Details::LabelStats& stats) {
+        snapshots.push_back(LabelSnapshot{ stats.name,
+                                           stats.invocations.load(std::memory_order_relaxed),
+                                           stats.cpuNanoseconds.load(std::memory_order_relaxed),
+                                           stats.wallNanoseconds.load(std::memory_order_relaxed),
+                                           stats.maxNanoseconds.load(std::memory_order_relaxed) });
+      });
+
+      return snapshots;
+    }
+  } // Labels
+}
+
+#endif // PROMISE_LABEL_H
@@ -9,13 +9,18 @@
 #ifndef PROMISE_PUBLIC_APIS_H
 #define PROMISE_PUBLIC_APIS_H
 
+#include <chrono>
+#include <cstdint>
 #include <functional>
+#include <future>
 #include <memory>
 #include <exception>
 #include <stdexcept>
+#include <vector>
  
 #include "../PromiseConfig.h"
 #include "../trait/declfn.h"
+#include "PromiseLabel.h"
 
 namespace Promise2 {
 
@@ -44,11 +49,22 @@ namespace Promise2 {
     template<typename ForwardType> class MultiValueForwardTrait;
     template<typename T> using DeferPromiseCore = std::shared_ptr<Forward<BoxVoid<T>, SingleValueForwardTrait>>;
     template<typename T> using DeferRecursionPromiseCore = std::shared_ptr<Forward<BoxVoid<T>, MultiValueForwardTrait>>;
+    template<typename T> class DeferredRecursionPromiseNodeInternal;
+    template<typename F> class MapStage;
+    template<typename Predicate> class FilterStage;
+    template<typename F> class FlatMapStage;
+    class TakeStage;
+    template<typename First, typename Second> class FusedStage;
+    template<typename T> class CoroutinePromiseType;
+#if USE_COROUTINE
+    template<typename T> class PromiseAwaiter;
+#endif // USE_COROUTINE
   } // Details
     
   // !
   template<typename T> class Promise;
   template<typename T> class RecursionPromise;
+  template<typename T, typename Fused> class PromiseContinuation;
   template<typename T> using SharedPromiseNode = std::shared_ptr<Details::PromiseNode<BoxVoid<T>>>;
   template<typename T> using SharedRecursionPromiseNode = std::shared_ptr<Details::RecursionPromiseNode<BoxVoid<T>>>;
   template<template<typename T> class PromiseType, typename K> using OnRejectFunctionGeneric = std::function<PromiseType<UnboxVoid<K>>(std::exception_ptr)>;
@@ -120,6 +136,48 @@ namespace Promise2 {
     PromiseDeferBase<void, RecursionMode>& operator = (const PromiseDeferBase<void, RecursionMode>&) = delete;
   };
 
+  //
+  // @class RecursionPromiseDefer
+  //  feeds a recursion promise from any threads, copies share the same recursion
+  //
+  template<typename T>
+  class RecursionPromiseDefer {
+  private:
+    std::shared_ptr<Details::DeferredRecursionPromiseNodeInternal<BoxVoid<T>>> _node;
+
+  public:
+    explicit RecursionPromiseDefer(const std::shared_ptr<Details::DeferredRecursionPromiseNodeInternal<BoxVoid<T>>>& node);
+
+  public:
+    // forwarded in the pushed order per thread
+    template<typename X> void push(X&& v);
+
+    // the recursion is rejected and halted, values pushed afterwards are discarded
+    void fail(std::exception_ptr e);
+
+    // the recursion is fulfilled once all the values pushed before have been forwarded
+    void finish();
+  };
+
+  //
+  // @struct RetryPolicy
+  //  exponential backoff for `Promise::Retry`
+  //
+  struct RetryPolicy {
+    // including the first attempt
+    std::uint32_t maxAttempts = 3;
+
+    std::chrono::nanoseconds initialDelay = std::chrono::milliseconds(100);
+    std::chrono::nanoseconds maxDelay = std::chrono::seconds(10);
+    double multiplier = 2.0;
+
+    // each delay is randomly shortened by at most `jitter` ratio, within [0, 1]
+    double jitter = 0.0;
+
+    // retry on any exception if empty
+    std::function<bool(std::exception_ptr)> retryIf;
+  };
+
   //
   // @using PromiseDefer
   //
@@ -138,6 +196,22 @@ namespace Promise2 {
       return std::move(Spawn(std::move(taskFn), std::move(context)));
     }
 
+    // `task` measured under the label when it runs
+    template<typename Task>
+    static Promise<T> New(Task&& task, ThreadContext* &&context, const Label& label) {
+      return New(label.wrap(declfn(task){ std::move(task) }), std::move(context));
+    }
+
+    // fulfilled within the context once the future is ready, no thread blocks on it
+    static Promise<T> FromFuture(std::future<T>&& future, ThreadContext* &&context);
+
+    // spawn by `taskFactory` -> `Promise<T>()` within the context, and spawn again after
+    // a delay whenever the spawned one rejected, till the policy gives up
+    template<typename TaskFactory>
+    static Promise<T> Retry(TaskFactory&& taskFactory, const RetryPolicy& policy, ThreadContext* &&context) {
+      return Spawn(std::function<Promise<T>()>{ std::forward<TaskFactory>(taskFactory) }, policy, std::move(context));
+    }
+
   private:
     // constructor with task and running context
     static Promise<T> Spawn(std::function<T(void)>&& task, ThreadContext* &&context);
@@ -148,6 +222,9 @@ namespace Promise2 {
     // constructor with nesting promise task
     static Promise<T> Spawn(std::function<Promise<T>()>&& task, ThreadContext* &&context);
 
+    // constructor with retry task factory
+    static Promise<T> Spawn(std::function<Promise<T>()>&& taskFactory, const RetryPolicy& policy, ThreadContext* &&context);
+
     // matching nothing
     template<typename NonMatching> static auto Spawn(NonMatching&&, ThreadContext* &&) -> std::false_type;
   };
@@ -198,8 +275,37 @@ namespace Promise2 {
   public:
     // iterator must implements std::input_iterator_tag supported operations
     // and under multi-threads context(recursion state pass to the receiver i.e. thenable promise) equality check and increment operation must be atomic
+    //
+    // random access range is split into chunks iterated by several tasks within the context,
+    // its dereference must be thread safe
     template<class InputIterator>
     static RecursionPromise<T> Iterate(InputIterator begin, InputIterator end, ThreadContext* &&context);
+
+    // bounded recursion, the iteration is suspended once `highWaterMark` values are pending on the receiver
+    // and resumed within the context after half of them consumed
+    template<class InputIterator>
+    static RecursionPromise<T> Iterate(InputIterator begin, InputIterator end, std::size_t highWaterMark, ThreadContext* &&context);
+
+    // the iterating tasks measured under the label, including what they run inline
+    template<class InputIterator>
+    static RecursionPromise<T> Iterate(InputIterator begin, InputIterator end, ThreadContext* &&context, const Label& label);
+
+    // `task` -> void(RecursionPromiseDefer<T>) runs within the context, and hands the defer to the producers
+    //  the pushed values are forwarded within the context in a single task at a time
+    //  the recursion is rejected if `task` throws
+    template<typename Task>
+    static RecursionPromise<T> Deferred(Task&& task, ThreadContext* &&context) {
+      return Spawn(std::function<void(RecursionPromiseDefer<T>)>{ std::forward<Task>(task) }, std::move(context));
+    }
+
+  private:
+    template<class InputIterator>
+    static RecursionPromise<T> Iterate(InputIterator begin, InputIterator end, ThreadContext* &&context, std::false_type isRandomAccess);
+
+    static RecursionPromise<T> Spawn(std::function<void(RecursionPromiseDefer<T>)>&& task, ThreadContext* &&context);
+
+    template<class RandomAccessIterator>
+    static RecursionPromise<T> Iterate(RandomAccessIterator begin, RandomAccessIterator end, ThreadContext* &&context, std::true_type isRandomAccess);
   };
 
   template<typename T>
@@ -212,8 +318,67 @@ namespace Promise2 {
                                                    ThreadContext* &&context);
   };
 
+  //
+  // results are emitted in the order the values notified
+  //  while the thenables still run in parallel within the context
+  //
+  template<typename T>
+  class OrderedRecursionPromiseThenable {
+  public:
+    template<typename NextT, typename ConvertibleT>
+    static RecursionPromise<UnboxVoid<NextT>> Then(SharedRecursionPromiseNode<T>& node,
+                                                   std::function<NextT(ConvertibleT)>&& onFulfill,
+                                                   OnRecursionRejectFunction<NextT>&& onReject, 
+                                                   ThreadContext* &&context,
+                                                   std::size_t window);
+  };
+
+  //
+  // @class RecursionPipeline
+  //  stages composed at compile time, which run fused in one task per value within the context given to `on()`
+  //
+  template<typename T, typename Stage>
+  class RecursionPipeline {
+  private:
+    SharedRecursionPromiseNode<T> _source;
+    Stage _stage;
+
+  public:
+    RecursionPipeline(const SharedRecursionPromiseNode<T>& source, Stage&& stage);
+
+  public:
+    // `f` -> U(T)
+    template<typename F>
+    RecursionPipeline<T, Details::FusedStage<Stage, Details::MapStage<std::decay_t<F>>>> map(F&& f) const;
+
+    // `predicate` -> bool(const T&)
+    template<typename Predicate>
+    RecursionPipeline<T, Details::FusedStage<Stage, Details::FilterStage<std::decay_t<Predicate>>>> filter(Predicate&& predicate) const;
+
+    // `f` -> any range of U, e.g. std::vector<U>
+    template<typename F>
+    RecursionPipeline<T, Details::FusedStage<Stage, Details::FlatMapStage<std::decay_t<F>>>> flatMap(F&& f) const;
+
+    // first `n` values in the processed order, and halts the previous recursions after that
+    RecursionPipeline<T, Details::FusedStage<Stage, Details::TakeStage>> take(std::size_t n) const;
+
+  public:
+    RecursionPromise<typename Stage::template Out<T>> on(ThreadContext* &&context) const;
+  };
+
   class FulfillIgnoreException {};
 
+  //
+  // @class TimeoutException
+  //  rejected reason of `Promise::timeout`
+  //
+  class TimeoutException : public std::runtime_error {
+  public:
+    TimeoutException()
+      : std::runtime_error{ "promise timeout" }
+    {}
+  };
+
   template<typename ReturnType, typename Argument>
   ReturnType ignoreFulfill(BoxVoid<Argument>) {
     throw FulfillIgnoreException{};
@@ -264,10 +429,12 @@ namespace Promise2 {
     SharedPromiseNodeType _node;
 
   protected:
-    template<typename Wrapper, typename Thenable, typename OnFulfill, typename OnReject>
+    // `extras` are passed through to the thenable
+    template<typename Wrapper, typename Thenable, typename OnFulfill, typename OnReject, typename... Extras>
     auto then(OnFulfill&& onFulfill,
               OnReject&& onReject, 
-              ThreadContext* &&context) {
+              ThreadContext* &&context,
+              Extras&&... extras) {
       static_assert(!std::is_same<declfn(onFulfill), std::false_type>::value &&
                     !std::is_same<declfn(onReject), std::false_type>::value , "you need to provide a callable");
 
@@ -279,21 +446,23 @@ namespace Promise2 {
       auto onRejectFn = declfn(onReject) { std::move(onReject) };
 #endif // ONREJECT_IMPLICITLY_RESOLVED
 
-      static_assert(!std::is_same<decltype(Thenable::Then(_node, std::move(onFulfillFn), std::move(onRejectFn), std::move(context))), std::false_type>::value, "match nothing...");
+      static_assert(!std::is_same<decltype(Thenable::Then(_node, std::move(onFulfillFn), std::move(onRejectFn), std::move(context), std::forward<Extras>(extras)...)), std::false_type>::value, "match nothing...");
 
       if (!isValid()) throw std::logic_error("invalid promise");
-      return Thenable::Then(_node, std::move(onFulfillFn), std::move(onRejectFn), std::move(context));
+      return Thenable::Then(_node, std::move(onFulfillFn), std::move(onRejectFn), std::move(context), std::forward<Extras>(extras)...);
     }
 
-    template<typename Wrapper, typename Thenable, typename OnFulfill>
+    template<typename Wrapper, typename Thenable, typename OnFulfill, typename... Extras>
     auto fulfill(OnFulfill&& onFulfill,
-                 ThreadContext* &&context) {
+                 ThreadContext* &&context,
+                 Extras&&... extras) {
 
       static_assert(!std::is_same<declfn(onFulfill), std::false_type>::value, "you need to provide a callable");
 
       return then<Wrapper, Thenable>(std::forward<OnFulfill>(onFulfill), 
                                      OnRejectFunctionGeneric<Wrapper::template Type, typename declfn(onFulfill)::result_type>{},
-                                     std::move(context));
+                                     std::move(context),
+                                     std::forward<Extras>(extras)...);
     }
 
     template<typename PromiseValueType, typename Wrapper, typename Thenable, typename OnReject>
@@ -316,6 +485,14 @@ namespace Promise2 {
     bool isFulfilled() const; 
     bool isRejected() const;
 
+  public:
+    // block the calling thread till settled
+    void wait() const;
+
+    // false if still running when timed out
+    template<typename Rep, typename Period>
+    bool wait_for(const std::chrono::duration<Rep, Period>& timeout) const;
+
   public:
     inline SharedPromiseNodeType internal() const { return _node; }
   };
@@ -331,6 +508,8 @@ namespace Promise2 {
                   public PromiseResolveSpawner<T> {
     template<typename Type> friend class PromiseThenable;
     template<typename Type> friend class PromiseResolveSpawner;
+    template<typename Type> friend class Details::CoroutinePromiseType;
+    template<typename Type> friend class RecursionPromise;
 
     friend class PromiseSpawner<T>;
 
@@ -371,7 +550,135 @@ namespace Promise2 {
     template<typename OnReject>
     auto caught(OnReject&& onReject, // < only allow returning void 
                ThreadContext* &&context) {
-      return Base::template reject<PromiseTypeWrapper, Thenable>(std::forward<OnReject>(onReject), std::move(context));
+      return Base::template reject<T, PromiseTypeWrapper, Thenable>(std::forward<OnReject>(onReject), std::move(context));
+    }
+
+    // the callbacks measured under the label when they run
+    template<typename OnFulfill, typename OnReject>
+    auto then(OnFulfill&& onFulfill,
+              OnReject&& onReject, 
+              ThreadContext* &&context,
+              const Label& label) {
+      return then(label.wrap(declfn(onFulfill){ std::move(onFulfill) }), label.wrap(declfn(onReject){ std::move(onReject) }), std::move(context));
+    }
+
+    template<typename OnFulfill>
+    auto then(OnFulfill&& onFulfill,
+              ThreadContext* &&context,
+              const Label& label) {
+      return then(label.wrap(declfn(onFulfill){ std::move(onFulfill) }), std::move(context));
+    }
+
+    template<typename OnReject>
+    auto caught(OnReject&& onReject,
+               ThreadContext* &&context,
+               const Label& label) {
+      return caught(label.wrap(declfn(onReject){ std::move(onReject) }), std::move(context));
+    }
+
+    // block till settled and take the result, rethrow if rejected
+    //  the promise is chained just like `then`
+    T get();
+
+    // settles the returned future directly when this promise settles
+    //  the promise is chained just like `then`
+    std::future<T> toFuture();
+
+    // rejected with `TimeoutException` if not settled within the given duration
+    template<typename Rep, typename Period>
+    Promise<T> timeout(const std::chrono::duration<Rep, Period>& duration,
+                       ThreadContext* &&context);
+
+    // `onFulfill` is fused with the continuations chained by the returned one, and they all run
+    // in the single task of the next `then`, passing the intermediate values on the stack
+    //  exceptions thrown by them reject the promise returned by `then`, as thrown by its `onFulfill`
+    template<typename OnFulfill>
+    PromiseContinuation<T, std::decay_t<OnFulfill>> thenInline(OnFulfill&& onFulfill);
+
+#if USE_COROUTINE
+    // `co_await` resumes the coroutine within the given context
+    //  while plain `co_await promise` resumes inline where the promise settles
+    Details::PromiseAwaiter<T> resumeOn(ThreadContext* &&context);
+#endif // USE_COROUTINE
+  };
+
+  namespace Details {
+    // `Second` takes the result of `First`, or nothing if `void`
+    template<typename First, typename Second>
+    class FusedCallable {
+    private:
+      First _first;
+      Second _second;
+
+    public:
+      FusedCallable(First&& first, Second&& second)
+        : _first{ std::move(first) }
+        , _second{ std::move(second) }
+      {}
+
+    public:
+      template<typename... Args>
+      decltype(auto) operator() (Args&&... args) {
+        return invoke(std::is_void<decltype(_first(std::forward<Args>(args)...))>{}, std::forward<Args>(args)...);
+      }
+
+    private:
+      template<typename... Args>
+      decltype(auto) invoke(std::false_type, Args&&... args) {
+        return _second(_first(std::forward<Args>(args)...));
+      }
+
+      template<typename... Args>
+      decltype(auto) invoke(std::true_type, Args&&... args) {
+        _first(std::forward<Args>(args)...);
+        return _second();
+      }
+    };
+
+    template<typename T, typename Fused> struct FusedFunction { using type = std::function<decltype(std::declval<Fused&>()(std::declval<T>()))(T)>; };
+    template<typename Fused> struct FusedFunction<void, Fused> { using type = std::function<decltype(std::declval<Fused&>()())()>; };
+  } // Details
+
+  //
+  // @class PromiseContinuation
+  //  continuations fused till chained by `then`, each call consumes it
+  //
+  template<typename T, typename Fused>
+  class PromiseContinuation {
+  private:
+    Promise<T> _source;
+    Fused _fused;
+
+  public:
+    PromiseContinuation(const Promise<T>& source, Fused&& fused)
+      : _source{ source }
+      , _fused{ std::move(fused) }
+    {}
+
+  public:
+    template<typename OnFulfill>
+    PromiseContinuation<T, Details::FusedCallable<Fused, std::decay_t<OnFulfill>>> thenInline(OnFulfill&& onFulfill) && {
+      return { _source, { std::move(_fused), std::decay_t<OnFulfill>{ std::forward<OnFulfill>(onFulfill) } } };
+    }
+
+    template<typename OnFulfill, typename OnReject>
+    auto then(OnFulfill&& onFulfill,
+              OnReject&& onReject, 
+              ThreadContext* &&context) && {
+      return _source.then(std::move(*this).fuse(std::forward<OnFulfill>(onFulfill)), std::forward<OnReject>(onReject), std::move(context));
+    }
+
+    template<typename OnFulfill>
+    auto then(OnFulfill&& onFulfill,
+              ThreadContext* &&context) && {
+      return _source.then(std::move(*this).fuse(std::forward<OnFulfill>(onFulfill)), std::move(context));
+    }
+
+  private:
+    template<typename OnFulfill>
+    auto fuse(OnFulfill&& onFulfill) && {
+      using FusedType = Details::FusedCallable<Fused, std::decay_t<OnFulfill>>;
+      return typename Details::FusedFunction<T, FusedType>::type{ FusedType{ std::move(_fused), std::decay_t<OnFulfill>{ std::forward<OnFulfill>(onFulfill) } } };
     }
   };
 
@@ -383,12 +690,16 @@ namespace Promise2 {
                            public PromiseRecursible<T> {
 
       template<typename Type> friend class RecursionPromiseThenable;
+      template<typename Type> friend class OrderedRecursionPromiseThenable;
       template<typename Type> friend class PromiseThenable;
       friend class PromiseRecursible<T>;
+      template<typename Type> friend class RecursionPromise;
+      template<typename Type, typename Stage> friend class RecursionPipeline;
 
   private:
     using Base = GenericPromise<SharedRecursionPromiseNode<T>>;
     using Thenable = RecursionPromiseThenable<BoxVoid<T>>;
+    using OrderedThenable = OrderedRecursionPromiseThenable<BoxVoid<T>>;
     using FinalThenable = PromiseThenable<Void>;
     using SelfType = RecursionPromise<T>;
 
@@ -422,6 +733,39 @@ namespace Promise2 {
       return Base::template fulfill<RecursionPromiseTypeWrapper, Thenable>(std::forward<OnFulfill>(onFulfill), std::move(context));
     }
 
+    // the callbacks measured under the label, once per value
+    template<typename OnFulfill, typename OnReject>
+    auto then(OnFulfill&& onFulfill,
+              OnReject&& onReject, 
+              ThreadContext* &&context,
+              const Label& label) {
+      return then(label.wrap(declfn(onFulfill){ std::move(onFulfill) }), label.wrap(declfn(onReject){ std::move(onReject) }), std::move(context));
+    }
+
+    template<typename OnFulfill>
+    auto then(OnFulfill&& onFulfill,
+              ThreadContext* &&context,
+              const Label& label) {
+      return then(label.wrap(declfn(onFulfill){ std::move(onFulfill) }), std::move(context));
+    }
+
+    // ordered mode, at most `window` values are running or waiting to be emitted at the same time
+    //  the recursion returned by `onReject` is chained as `then` does, its values are relayed as they settle instead of in order
+    template<typename OnFulfill, typename OnReject>
+    auto thenOrdered(std::size_t window,
+                     OnFulfill&& onFulfill,
+                     OnReject&& onReject, 
+                     ThreadContext* &&context) {
+      return Base::template then<RecursionPromiseTypeWrapper, OrderedThenable>(std::forward<OnFulfill>(onFulfill), std::forward<OnReject>(onReject), std::move(context), window);
+    }
+
+    template<typename OnFulfill>
+    auto thenOrdered(std::size_t window,
+                     OnFulfill&& onFulfill,
+                     ThreadContext* &&context) {
+      return Base::template fulfill<RecursionPromiseTypeWrapper, OrderedThenable>(std::forward<OnFulfill>(onFulfill), std::move(context), window);
+    }
+
     // OnFulfill -> void(void)
     template<typename OnFulfill, typename OnReject>
     auto final(OnFulfill&& onFulfill,
@@ -435,6 +779,42 @@ namespace Promise2 {
                ThreadContext* &&context) {
       return Base::template fulfill<PromiseTypeWrapper, FinalThenable>(std::forward<OnFulfill>(onFulfill), std::move(context));
     }
+
+    // fused stages, see `RecursionPipeline`
+    template<typename F>
+    RecursionPipeline<T, Details::MapStage<std::decay_t<F>>> map(F&& f);
+
+    template<typename Predicate>
+    RecursionPipeline<T, Details::FilterStage<std::decay_t<Predicate>>> filter(Predicate&& predicate);
+
+    template<typename F>
+    RecursionPipeline<T, Details::FlatMapStage<std::decay_t<F>>> flatMap(F&& f);
+
+    RecursionPipeline<T, Details::TakeStage> take(std::size_t n);
+
+    // folds the values into `Acc`, `combine` -> Acc(Acc, T)
+    //  each notifying thread folds into its own partial from `identity` inline, locked only when a thread registers its partial
+    //  the partials are merged by `merge` -> Acc(Acc, Acc) within the context once finished, in no particular order
+    //  so `merge` must be associative and commutative
+    //  rejected if any value or the recursion itself is rejected
+    template<typename Acc, typename Combine, typename Merge>
+    Promise<Acc> reduce(Acc identity, Combine&& combine, Merge&& merge, ThreadContext* &&context);
+
+    // `combine` is used to merge the partials as well
+    template<typename Acc, typename Combine>
+    Promise<Acc> reduce(Acc identity, Combine&& combine, ThreadContext* &&context) {
+      auto merge = combine;
+      return reduce(std::move(identity), std::forward<Combine>(combine), std::move(merge), std::move(context));
+    }
+
+    // gathers up to `maxChunkSize` values into one chunk in the notified order
+    //  the rest are delivered as the last chunk once finished
+    //  chain `then` to the returned promise to handle a chunk per task
+    RecursionPromise<std::vector<T>> chunked(std::size_t maxChunkSize);
+
+    // block till the recursion finished, rethrow if rejected
+    //  the promise is chained just like `final`
+    void get();
   };
 }
  
@@ -0,0 +1,212 @@
+/*
+ * Promise2
+ *
+ * Copyright (c) 2016 "0of" Magnus
+ * Licensed under the MIT license.
+ * https://github.com/0of/Promise2/blob/master/LICENSE
+ */
+
+//
+// `operator new/delete` interposed to hold the canonical operations to their allocation budgets
+//  lower the budget once an allocation is removed, never raise it without a reason
+//
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <new>
+
+#include "entry.h"
+#include "Promise.h"
+
+namespace {
+  // only the measuring thread counts, the runner may allocate elsewhere meanwhile
+  struct AllocationCounter {
+    bool armed = false;
+    std::size_t count = 0;
+    std::size_t bytes = 0;
+  };
+
+  thread_local AllocationCounter counter;
+
+  void *allocate(std::size_t size) {
+    if (counter.armed) {
+      ++counter.count;
+      counter.bytes += size;
+    }
+
+    if (auto p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc{};
+  }
+}
+
+void *operator new(std::size_t size) { return allocate(size); }
+void *operator new[](std::size_t size) { return allocate(size); }
+void *operator new(std::size_t size, const std::nothrow_t&) noexcept { return std::malloc(size ? size : 1); }
+void *operator new[](std::size_t size, const std::nothrow_t&) noexcept { return std::malloc(size ? size : 1); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+
+class CurrentContext : public Promise2::ThreadContext {
+public:
+  static ThreadContext *New() {
+    return new CurrentContext;
+  }
+
+public:
+  virtual void scheduleToRun(std::function<void()>&& task) override {
+    task();
+  }
+};
+
+// runs the tasks once asked, so the recursion iterates after chained
+class QueuedContext : public Promise2::ThreadContext {
+public:
+  static std::deque<std::function<void()>>& tasks() {
+    static std::deque<std::function<void()>> queued;
+    return queued;
+  }
+
+  static ThreadContext *New() {
+    return new QueuedContext;
+  }
+
+  static void runAll() {
+    while (!tasks().empty()) {
+      auto task = std::move(tasks().front());
+      tasks().pop_front();
+      task();
+    }
+  }
+
+public:
+  virtual void scheduleToRun(std::function<void()>&& task) override {
+    tasks().push_back(std::move(task));
+  }
+};
+
+namespace AllocationBudget {
+
+  struct Budget {
+    std::size_t count;
+    // sizes vary with the standard library, a ceiling only
+    std::size_t bytes;
+  };
+
+  // the operation runs once to warm up statics, the second run is measured
+  template<typename Operation>
+  AllocationCounter measure(Operation&& operation) {
+    operation();
+
+    counter = AllocationCounter{};
+    counter.armed = true;
+    operation();
+    counter.armed = false;
+
+    return counter;
+  }
+
+  // the budgets are taken from libstdc++, other libraries only report
+  void expect(const char *operation, const AllocationCounter& used, const Budget& budget) {
+    if (used.count != budget.count || used.bytes > budget.bytes) {
+      std::fprintf(stderr, "%s: %zu allocations of %zu bytes, budget %zu allocations within %zu bytes\n",
+                   operation, used.count, used.bytes, budget.count, budget.bytes);
+#if defined(__GLIBCXX__)
+      throw AssertionFailed();
+#endif // __GLIBCXX__
+    }
+  }
+
+  template<typename T>
+  void init(T& spec) {
+    spec
+    /* ==> */
+    .it("should resolve within budget", [] {
+      auto used = measure([] {
+        auto p = Promise2::Promise<int>::Resolved(1);
+      });
+
+      expect("Resolved", used, Budget{ 2, 72 });
+    })
+    /* ==> */
+    .it("should append one then within budget", [] {
+      auto used = measure([] {
+        auto p = Promise2::Promise<int>::Resolved(1);
+        p.then([](int v) { return v + 1; }, CurrentContext::New());
+      });
+
+      expect("then", used, Budget{ 11, 432 });
+    })
+    /* ==> */
+    .it("should catch within budget", [] {
+      auto e = std::make_exception_ptr(UserException());
+
+      auto used = measure([&] {
+        auto p = Promise2::Promise<int>::Rejected(e);
+        p.caught([](std::exception_ptr) {}, CurrentContext::New());
+      });
+
+      expect("caught", used, Budget{ 13, 496 });
+    })
+    /* ==> */
+    .it("should round trip a deferred promise within budget", [] {
+      auto used = measure([] {
+        auto p = Promise2::Promise<int>::New([](Promise2::PromiseDefer<int>&& deferred) {
+          deferred.setResult(1);
+        }, CurrentContext::New());
+
+        p.then([](int v) { return v + 1; }, CurrentContext::New());
+      });
+
+      expect("PromiseDefer", used, Budget{ 19, 736 });
+    })
+    /* ==> */
+    .it("should forward one recursion element within budget", [] {
+      constexpr std::int32_t elements = 256;
+
+      class CountingIterator {
+      private:
+        std::int32_t _index;
+
+      public:
+        explicit CountingIterator(std::int32_t index) : _index{ index } {}
+
+      public:
+        bool operator != (const CountingIterator& i) { return i._index != _index; }
+
+        CountingIterator& operator++ () {
+          ++_index;
+          return *this;
+        }
+
+        std::int32_t operator *() const { return _index; }
+      };
+
+      auto stream = [](std::int32_t count) {
+        return measure([=] {
+          auto p = Promise2::RecursionPromise<std::int32_t>::Iterate(CountingIterator(0), CountingIterator(count), QueuedContext::New());
+          p.then([](std::int32_t ) {}, CurrentContext::New()).
+            final([] {}, [](std::exception_ptr e) { return Promise2::Promise<void>::Rejected(e); }, CurrentContext::New());
+
+          QueuedContext::runAll();
+        });
+      };
+
+      // the stream setup is cancelled out
+      //  the scheduled task of `then`, and its `Void` value held as nothing chained to the values
+      auto once = stream(elements);
+      auto twice = stream(elements * 2);
+
+      AllocationCounter used;
+      used.count = (twice.count - once.count) / elements;
+      used.bytes = (twice.bytes - once.bytes) / elements;
+
+      expect("RecursionPromise element", used, Budget{ 2, 120 });
+    });
+  }
+}
+
+TEST_ENTRY(CONTAINER_TYPE,
+  SPEC_TFN(AllocationBudget::init));
@@ -0,0 +1,103 @@
+/*
+ * Promise2
+ *
+ * Copyright (c) 2016 "0of" Magnus
+ * Licensed under the MIT license.
+ * https://github.com/0of/Promise2/blob/master/LICENSE
+ */
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "entry.h"
+#include "Promise.h"
+#include "context/ThreadContext_STL.h"
+
+class CurrentContext : public Promise2::ThreadContext {
+public:
+  static ThreadContext *New() {
+    return new CurrentContext;
+  }
+
+public:
+  virtual void scheduleToRun(std::function<void()>&& task) override {
+    task(); 
+  }
+};
+
+using STLThreadContext = ThreadContextImpl::STL::DetachedThreadContext;
+
+#if USE_COROUTINE
+
+namespace CoroutineAPIsBase {
+
+  Promise2::Promise<std::int32_t> add(std::int32_t a, std::int32_t b) {
+    auto x = co_await Promise2::Promise<std::int32_t>::Resolved(a);
+    auto y = co_await Promise2::Promise<std::int32_t>::New([=] { return b; }, STLThreadContext::New());
+
+    co_return x + y;
+  }
+
+  Promise2::Promise<void> throwing() {
+    co_await Promise2::Promise<void>::Rejected(std::make_exception_ptr(UserException()));
+  }
+
+  Promise2::Promise<std::thread::id> resumedOn(Promise2::ThreadContext* &&context) {
+    co_await Promise2::Promise<void>::Resolved().resumeOn(std::move(context));
+    co_return std::this_thread::get_id();
+  }
+
+  template<typename T>
+  void init(T& spec) {
+    using context = CurrentContext;
+
+    spec
+    /* ==> */
+    .it("should be fulfilled with the returned value", [](const LTest::SharedCaseEndNotifier& notifier) {
+      add(1, 2).then([=](std::int32_t v) {
+        if (3 == v)
+          notifier->done();
+        else
+          notifier->fail(std::make_exception_ptr(AssertionFailed()));
+      }, [=](std::exception_ptr) {
+        notifier->fail(std::make_exception_ptr(AssertionFailed()));
+      }, context::New());
+    })
+    /* ==> */
+    .it("should be rejected when the awaited promise rejected", [](const LTest::SharedCaseEndNotifier& notifier) {
+      throwing().then([=]() {
+        notifier->fail(std::make_exception_ptr(AssertionFailed()));
+      }, [=](std::exception_ptr e) {
+        try {
+          std::rethrow_exception(e);
+        } catch (const UserException&) {
+          notifier->done();
+        } catch (...) {
+          notifier->fail(std::make_exception_ptr(AssertionFailed()));
+        }
+      }, context::New());
+    })
+    /* ==> */
+    .it("should resume within the given context", [] {
+      if (std::this_thread::get_id() == resumedOn(STLThreadContext::New()).get())
+        throw AssertionFailed();
+    })
+    /* ==> */
+    .it("should resume inline when already settled", [] {
+      if (std::this_thread::get_id() != resumedOn(CurrentContext::New()).get())
+        throw AssertionFailed();
+    });
+  }
+
+} // CoroutineAPIsBase
+
+TEST_ENTRY(CONTAINER_TYPE,
+  SPEC_TFN(CoroutineAPIsBase::init));
+
+#else
+
+// nothing to test without coroutine support
+int main() { return 0; }
+
+#endif // USE_COROUTINE
@@ -27,6 +27,8 @@
 #include "Promise.h"
 #include "entry.h"
 #include "context/ThreadContext_STL.h"
+#include "context/ThreadContext_Metrics.h"
+#include "context/ThreadContext_Simulated.h"
 
 #ifdef __APPLE__
  #include "context/ThreadContext_GCD.h"
@@ -427,6 +429,18 @@ namespace PromiseAPIsBase {
         notifier->fail(std::make_exception_ptr(AssertionFailed()));
         return Promise2::Promise<void>::Rejected(std::make_exception_ptr(AssertionFailed()));
       }, CurrentContext::New());
+    })
+    /* ==> */
+    .it("should invoke the handler given to caught", [](const LTest::SharedCaseEndNotifier& notifier) {
+      Promise2::Promise<int>::Rejected(std::make_exception_ptr(UserException())).caught([=](std::exception_ptr e) {
+        try {
+          std::rethrow_exception(e);
+        } catch (const UserException&) {
+          notifier->done();
+        } catch (...) {
+          notifier->fail(std::make_exception_ptr(AssertionFailed()));
+        }
+      }, CurrentContext::New());
     });
     // end of the init spec
   }
@@ -1193,12 +1207,657 @@ namespace OnRejectImplicitlyResolved {
   }
 }
 
+namespace PromiseTimeout {
+  template<typename T>
+  void init(T& spec) {
+    using context = CurrentContext;
+
+    spec
+    /* ==> */
+    .it("should be rejected with timeout exception when never settled", [](const LTest::SharedCaseEndNotifier& notifier) {
+      Promise2::Promise<int>::New([](Promise2::PromiseDefer<int>&&) {
+        // never settled
+      }, context::New()).timeout(std::chrono::milliseconds(10), context::New()).then([=](int) {
+        notifier->fail(std::make_exception_ptr(AssertionFailed()));
+      }, [=](std::exception_ptr e) {
+        try {
+          std::rethrow_exception(e);
+        } catch (const Promise2::TimeoutException&) {
+          notifier->done();
+        } catch (...) {
+          notifier->fail(std::make_exception_ptr(AssertionFailed()));
+        }
+      }, context::New());
+    })
+    /* ==> */
+    .it("should forward the value when settled before timeout", [](const LTest::SharedCaseEndNotifier& notifier) {
+      constexpr int constant = 1;
+
+      Promise2::Promise<int>::Resolved(constant).timeout(std::chrono::seconds(1), context::New()).then([=](int v) {
+        if (constant == v)
+          notifier->done();
+        else
+          notifier->fail(std::make_exception_ptr(AssertionFailed()));
+      }, [=](std::exception_ptr) {
+        notifier->fail(std::make_exception_ptr(AssertionFailed()));
+      }, context::New());
+    })
+    /* ==> */
+    .it("should forward the source exception when rejected before timeout", [](const LTest::SharedCaseEndNotifier& notifier) {
+      Promise2::Promise<void>::Rejected(std::make_exception_ptr(UserException())).timeout(std::chrono::seconds(1), context::New()).then([=]() {
+        notifier->fail(std::make_exception_ptr(AssertionFailed()));
+      }, [=](std::exception_ptr e) {
+        try {
+          std::rethrow_exception(e);
+        } catch (const UserException&) {
+          notifier->done();
+        } catch (...) {
+          notifier->fail(std::make_exception_ptr(AssertionFailed()));
+        }
+      }, context::New());
+    })
+    /* ==> */
+    .it("should expire massive pending timeouts", [](const LTest::SharedCaseEndNotifier& notifier) {
+      constexpr std::int32_t count = 100000;
+      auto expired = std::make_shared<std::atomic<std::int32_t>>(0);
+
+      for (std::int32_t i = 0; i < count; ++i) {
+        Promise2::Promise<int>::New([](Promise2::PromiseDefer<int>&&) {
+          // never settled
+        }, context::New()).timeout(std::chrono::milliseconds(50), context::New()).then([=](int) {
+          notifier->fail(std::make_exception_ptr(AssertionFailed()));
+        }, [=](std::exception_ptr) {
+          if (++*expired == count)
+            notifier->done();
+        }, context::New());
+      }
+    });
+  }
+}
+
+namespace PromiseWait {
+  template<typename T>
+  void init(T& spec) {
+    spec
+    /* ==> */
+    .it("should get the value when fulfilled", [] {
+      constexpr int constant = 1;
+
+      auto p = Promise2::Promise<int>::New([=] { return constant; }, STLThreadContext::New());
+      if (constant != p.get())
+        throw AssertionFailed();
+    })
+    /* ==> */
+    .it("should get the value through then chain", [] {
+      auto p = Promise2::Promise<int>::New([] { return 1; }, STLThreadContext::New()).then([](int v) {
+        return std::to_string(v);
+      }, STLThreadContext::New());
+
+      if ("1" != p.get())
+        throw AssertionFailed();
+    })
+    /* ==> */
+    .it("should rethrow when rejected", [] {
+      auto p = Promise2::Promise<void>::New([] { throw UserException(); }, STLThreadContext::New());
+
+      try {
+        p.get();
+      } catch (const UserException&) {
+        return;
+      }
+
+      throw AssertionFailed();
+    })
+    /* ==> */
+    .it("should wait till settled", [] {
+      auto p = Promise2::Promise<void>::New([] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      }, STLThreadContext::New());
+
+      p.wait();
+      if (!p.isFulfilled())
+        throw AssertionFailed();
+    })
+    /* ==> */
+    .it("should time out when never settled", [] {
+      auto p = Promise2::Promise<int>::New([](Promise2::PromiseDefer<int>&&) {
+        // never settled
+      }, CurrentContext::New());
+
+      if (p.wait_for(std::chrono::milliseconds(10)))
+        throw AssertionFailed();
+    })
+    /* ==> */
+    .it("should not time out when settled", [] {
+      auto p = Promise2::Promise<int>::New([] { return 1; }, STLThreadContext::New());
+
+      if (!p.wait_for(std::chrono::seconds(5)) || !p.isFulfilled())
+        throw AssertionFailed();
+    });
+  }
+}
+
+namespace PromiseFuture {
+  template<typename T>
+  void init(T& spec) {
+    using context = CurrentContext;
+
+    spec
+    /* ==> */
+    .it("should be fulfilled when the future is ready", [](const LTest::SharedCaseEndNotifier& notifier) {
+      constexpr int constant = 1;
+
+      auto future = std::async(std::launch::async, [=] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        return constant;
+      });
+
+      Promise2::Promise<int>::FromFuture(std::move(future), context::New()).then([=](int v) {
+        if (constant == v)
+          notifier->done();
+        else
+          notifier->fail(std::make_exception_ptr(AssertionFailed()));
+      }, [=](std::exception_ptr) {
+        notifier->fail(std::make_exception_ptr(AssertionFailed()));
+      }, context::New());
+    })
+    /* ==> */
+    .it("should evaluate the deferred future within the context", [](const LTest::SharedCaseEndNotifier& notifier) {
+      auto future = std::async(std::launch::deferred, [] {});
+
+      Promise2::Promise<void>::FromFuture(std::move(future), STLThreadContext::New()).then([=]() {
+        notifier->done();
+      }, [=](std::exception_ptr) {
+        notifier->fail(std::make_exception_ptr(AssertionFailed()));
+      }, context::New());
+    })
+    /* ==> */
+    .it("should be rejected when the future throws", [](const LTest::SharedCaseEndNotifier& notifier) {
+      std::promise<int> promise;
+      Promise2::Promise<int>::FromFuture(promise.get_future(), context::New()).then([=](int) {
+        notifier->fail(std::make_exception_ptr(AssertionFailed()));
+      }, [=](std::exception_ptr) {
+        notifier->done();
+      }, context::New());
+
+      promise.set_exception(std::make_exception_ptr(UserException()));
+    })
+    /* ==> */
+    .it("should fulfill the future", [] {
+      constexpr int constant = 1;
+
+      auto future = Promise2::Promise<int>::New([=] { return constant; }, STLThreadContext::New()).toFuture();
+      if (constant != future.get())
+        throw AssertionFailed();
+    })
+    /* ==> */
+    .it("should reject the future", [] {
+      auto future = Promise2::Promise<void>::Rejected(std::make_exception_ptr(UserException())).toFuture();
+
+      try {
+        future.get();
+      } catch (const UserException&) {
+        return;
+      }
+
+      throw AssertionFailed();
+    });
+  }
+}
+
+namespace PromiseRetry {
+  Promise2::RetryPolicy fastPolicy(std::uint32_t maxAttempts) {
+    Promise2::RetryPolicy policy;
+    policy.maxAttempts = maxAttempts;
+    policy.initialDelay = std::chrono::milliseconds(1);
+    policy.jitter = 0.5;
+
+    return policy;
+  }
+
+  template<typename T>
+  void init(T& spec) {
+    using context = CurrentContext;
+
+    spec
+    /* ==> */
+    .it("should be fulfilled after retries", [](const LTest::SharedCaseEndNotifier& notifier) {
+      auto attempts = std::make_shared<std::atomic<std::uint32_t>>(0);
+
+      Promise2::Promise<int>::Retry([=] {
+        return Promise2::Promise<int>::New([=]() -> int {
+          if (++*attempts < 3) throw UserException();
+          return 1;
+        }, STLThreadContext::New());
+      }, fastPolicy(3), context::New()).then([=](int v) {
+        if (1 == v && 3 == *attempts)
+          notifier->done();
+        else
+          notifier->fail(std::make_exception_ptr(AssertionFailed()));
+      }, [=](std::exception_ptr) {
+        notifier->fail(std::make_exception_ptr(AssertionFailed()));
+      }, context::New());
+    })
+    /* ==> */
+    .it("should be rejected when attempts exhausted", [](const LTest::SharedCaseEndNotifier& notifier) {
+      auto attempts = std::make_shared<std::uint32_t>(0);
+
+      Promise2::Promise<void>::Retry([=] {
+        ++*attempts;
+        return Promise2::Promise<void>::Rejected(std::make_exception_ptr(UserException()));
+      }, fastPolicy(4), context::New()).then([=]() {
+        notifier->fail(std::make_exception_ptr(AssertionFailed()));
+      }, [=](std::exception_ptr) {
+        if (4 == *attempts)
+          notifier->done();
+        else
+          notifier->fail(std::make_exception_ptr(AssertionFailed()));
+      }, context::New());
+    })
+    /* ==> */
+    .it("should not retry when the predicate denies", [](const LTest::SharedCaseEndNotifier& notifier) {
+      auto attempts = std::make_shared<std::uint32_t>(0);
+
+      auto policy = fastPolicy(4);
+      policy.retryIf = [](std::exception_ptr e) {
+        try {
+          std::rethrow_exception(e);
+        } catch (const UserException&) {
+          return false;
+        } catch (...) {
+          return true;
+        }
+      };
+
+      Promise2::Promise<int>::Retry([=]() -> Promise2::Promise<int> {
+        ++*attempts;
+        throw UserException();
+      }, policy, context::New()).then([=](int) {
+        notifier->fail(std::make_exception_ptr(AssertionFailed()));
+      }, [=](std::exception_ptr) {
+        if (1 == *attempts)
+          notifier->done();
+        else
+          notifier->fail(std::make_exception_ptr(AssertionFailed()));
+      }, context::New());
+    });
+  }
+}
+
+namespace PromiseThenInline {
+  template<typename T>
+  void init(T& spec) {
+    using context = CurrentContext;
+
+    spec
+    /* ==> */
+    .it("should run the fused continuations in one task", [](const LTest::SharedCaseEndNotifier& notifier) {
+      auto scheduled = std::make_shared<std::atomic<std::uint32_t>>(0);
+
+      class CountingContext : public Promise2::ThreadContext {
+      private:
+        std::shared_ptr<std::atomic<std::uint32_t>> _scheduled;
+
+      public:
+        explicit CountingContext(const std::shared_ptr<std::atomic<std::uint32_t>>& scheduled) : _scheduled{ scheduled } {}
+
+      public:
+        virtual void scheduleToRun(std::function<void()>&& task) override {
+          ++*_scheduled;
+          task();
+        }
+      };
+
+      Promise2::Promise<int>::Resolved(1).
+      thenInline([](int v) { return v + 1; }).
+      thenInline([](int v) { return std::to_string(v); }).
+      thenInline([](std::string s) { (void)s; }).
+      then([=]() { return 42; }, new CountingContext(scheduled)).
+      then([=](int v) {
+        if (42 == v && 1 == *scheduled)
+          notifier->done();
+        else
+          notifier->fail(std::make_exception_ptr(AssertionFailed()));
+      }, context::New());
+    })
+    /* ==> */
+    .it("should reject when the fused continuation throws", [](const LTest::SharedCaseEndNotifier& notifier) {
+      Promise2::Promise<void>::Resolved().
+      thenInline([]() -> int { throw UserException(); }).
+      then([](int v) { return v; }, context::New()).
+      // rejected just like thrown by `onFulfill` of the chained one
+      then([=](int) {
+        notifier->fail(std::make_exception_ptr(AssertionFailed()));
+      }, [=](std::exception_ptr e) {
+        try {
+          std::rethrow_exception(e);
+        } catch (const UserException&) {
+          notifier->done();
+        } catch (...) {
+          notifier->fail(std::make_exception_ptr(AssertionFailed()));
+        }
+      }, context::New());
+    });
+  }
+}
+
+namespace MeasuredContext {
+  template<typename T>
+  void init(T& spec) {
+    using namespace ThreadContextImpl::Metrics;
+
+    spec
+    /* ==> */
+    .it("should count the tasks scheduled through the measured context", [] {
+      auto metrics = ContextMetrics::New();
+
+      auto p = Promise2::Promise<int>::New([] { return 1; }, MeasuredThreadContext::New(ThreadContextImpl::STL::DetachedThreadContext::New(), metrics));
+      for (int i = 0; i < 8; ++i) {
+        p = p.then([](int v) { return v + 1; }, MeasuredThreadContext::New(ThreadContextImpl::STL::DetachedThreadContext::New(), metrics));
+      }
+
+      if (9 != p.get()) throw AssertionFailed();
+
+      // the last task may still be recording when `get` returns
+      auto snapshot = metrics->snapshot();
+      for (int i = 0; snapshot.completed != 9 && i < 1000; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        snapshot = metrics->snapshot();
+      }
+
+      if (9 != snapshot.enqueued || 9 != snapshot.started || 9 != snapshot.completed || 0 != snapshot.queueDepth)
+        throw AssertionFailed();
+
+      if (9 != snapshot.waitTime.count || 9 != snapshot.runTime.count)
+        throw AssertionFailed();
+    })
+    /* ==> */
+    .it("should report the queued tasks and their wait time", [] {
+      class QueuedContext : public Promise2::ThreadContext {
+      public:
+        std::vector<std::function<void()>> *tasks;
+
+      public:
+        explicit QueuedContext(std::vector<std::function<void()>> *queued) : tasks{ queued } {}
+
+      public:
+        virtual void scheduleToRun(std::function<void()>&& task) override {
+          tasks->push_back(std::move(task));
+        }
+      };
+
+      auto metrics = ContextMetrics::New();
+      std::vector<std::function<void()>> tasks;
+
+      for (int i = 0; i < 4; ++i) {
+        Promise2::Promise<int>::New([] { return 1; }, MeasuredThreadContext::New(new QueuedContext(&tasks), metrics));
+      }
+
+      auto queued = metrics->snapshot();
+      if (4 != queued.enqueued || 4 != queued.queueDepth || 0 != queued.completed)
+        throw AssertionFailed();
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      for (auto& task : tasks) task();
+
+      auto ran = metrics->snapshot();
+      if (0 != ran.queueDepth || 4 != ran.completed || ran.tasksPerSecond <= 0)
+        throw AssertionFailed();
+
+      // every task waited at least the sleep, within the bucket error
+      if (ran.waitTime.valueAtPercentile(0) < 1000000 || ran.waitTime.valueAtPercentile(100) < ran.waitTime.valueAtPercentile(50))
+        throw AssertionFailed();
+    })
+    /* ==> */
+    .it("should bucket the recorded values within the relative error", [] {
+      for (std::uint64_t value : { 0ull, 7ull, 8ull, 15ull, 1000ull, 123456789ull, ~0ull }) {
+        auto lower = HistogramSnapshot::lowerBoundOf(HistogramSnapshot::indexOf(value));
+        if (lower > value || value - lower > lower / HistogramSnapshot::SubBuckets)
+          throw AssertionFailed();
+      }
+    });
+  }
+}
+
+namespace SimulatedScheduling {
+  template<typename T>
+  void init(T& spec) {
+    using namespace ThreadContextImpl::Simulated;
+
+    spec
+    /* ==> */
+    .it("should run the scheduled tasks only when driven", [] {
+      auto simulation = Simulation::New();
+
+      auto p = Promise2::Promise<int>::New([] { return 1; }, SimulatedContext::New(simulation)).
+        then([](int v) { return v + 1; }, SimulatedContext::New(simulation));
+
+      if (p.isFulfilled() || 1 != simulation->pending())
+        throw AssertionFailed();
+
+      // the `then` task scheduled once the first ran
+      if (2 != simulation->runUntilIdle() || 2 != simulation->scheduled())
+        throw AssertionFailed();
+
+      if (2 != p.get())
+        throw AssertionFailed();
+    })
+    /* ==> */
+    .it("should run the delayed tasks on the virtual clock", [] {
+      auto simulation = Simulation::New();
+
+      auto p = Promise2::Promise<int>::New([] { return 1; }, SimulatedContext::New(simulation, std::chrono::milliseconds(10)));
+
+      if (0 != simulation->advance(std::chrono::milliseconds(5)) || p.isFulfilled())
+        throw AssertionFailed();
+
+      if (1 != simulation->advance(std::chrono::milliseconds(5)) || !p.isFulfilled())
+        throw AssertionFailed();
+
+      if (std::chrono::milliseconds(10) != simulation->now())
+        throw AssertionFailed();
+    })
+    /* ==> */
+    .it("should interleave the due tasks by the seed", [] {
+      auto orderOf = [](std::uint64_t seed) {
+        auto simulation = Simulation::New(seed);
+        std::vector<int> order;
+
+        for (int i = 0; i < 8; ++i) {
+          simulation->schedule([&order, i] { order.push_back(i); }, Simulation::Duration::zero());
+        }
+
+        simulation->runUntilIdle();
+        return order;
+      };
+
+      if (orderOf(7) != orderOf(7))
+        throw AssertionFailed();
+
+      bool interleaved = false;
+      for (std::uint64_t seed = 1; seed < 16 && !interleaved; ++seed) {
+        interleaved = orderOf(seed) != orderOf(0);
+      }
+
+      if (!interleaved)
+        throw AssertionFailed();
+    })
+    /* ==> */
+    .it("should forward the value whichever of settling and chaining comes first", [] {
+      std::uint32_t settledFirst = 0;
+      std::uint32_t chainedFirst = 0;
+
+      for (std::uint64_t seed = 0; seed < 32; ++seed) {
+        auto simulation = Simulation::New(seed);
+
+        std::vector<int> order;
+        std::unique_ptr<Promise2::PromiseDefer<int>> defer;
+
+        auto p = Promise2::Promise<int>::New([&](Promise2::PromiseDefer<int>&& deferred) {
+          defer.reset(new Promise2::PromiseDefer<int>(std::move(deferred)));
+        }, CurrentContext::New());
+
+        Promise2::Promise<int> chained;
+
+        simulation->schedule([&] { order.push_back(0); defer->setResult(41); }, Simulation::Duration::zero());
+        simulation->schedule([&] { order.push_back(1); chained = p.then([](int v) { return v + 1; }, CurrentContext::New()); }, Simulation::Duration::zero());
+        simulation->runUntilIdle();
+
+        if (42 != chained.get())
+          throw AssertionFailed();
+
+        ++(0 == order.front() ? settledFirst : chainedFirst);
+      }
+
+      if (0 == settledFirst || 0 == chainedFirst)
+        throw AssertionFailed();
+    });
+  }
+}
+
+namespace LabelledCallbacks {
+  Promise2::Labels::LabelSnapshot snapshotOf(const std::string& name) {
+    for (auto& snapshot : Promise2::Labels::snapshot()) {
+      if (name == snapshot.name) return snapshot;
+    }
+
+    throw AssertionFailed();
+  }
+
+  template<typename T>
+  void init(T& spec) {
+    using context = CurrentContext;
+
+    spec
+    /* ==> */
+    .it("should measure the labelled callbacks", [] {
+      auto p = Promise2::Promise<int>::New([] { return 1; }, context::New(), "labelled.new").
+        then([](int v) {
+          // keeps the CPU busy for a while
+          volatile std::uint64_t sum = 0;
+          for (std::uint64_t i = 0; i < 1000000; ++i) sum = sum + i;
+          return v + 1;
+        }, context::New(), "labelled.then").
+        then([](int) -> int { throw UserException(); }, [](std::exception_ptr e) { return Promise2::Promise<int>::Rejected(e); }, context::New(), "labelled.throw");
+
+      p.caught([](std::exception_ptr) {}, context::New(), "labelled.caught").wait();
+
+      if (1 != snapshotOf("labelled.new").invocations || 1 != snapshotOf("labelled.caught").invocations)
+        throw AssertionFailed();
+
+      auto busy = snapshotOf("labelled.then");
+      if (1 != busy.invocations || 0 == busy.cpuNanoseconds || busy.maxNanoseconds != busy.wallNanoseconds)
+        throw AssertionFailed();
+
+      // `onReject` only runs when the previous one rejected
+      if (1 != snapshotOf("labelled.throw").invocations)
+        throw AssertionFailed();
+    })
+    /* ==> */
+    .it("should share the stats among the labels of the same name", [] {
+      Promise2::Label label{ "labelled.shared" };
+
+      for (int i = 0; i < 3; ++i) {
+        Promise2::Promise<void>::Resolved().then([] {}, context::New(), label);
+      }
+
+      Promise2::Promise<void>::Resolved().then([] {}, context::New(), std::string{ "labelled.shared" });
+
+      if (4 != snapshotOf("labelled.shared").invocations)
+        throw AssertionFailed();
+    });
+  }
+}
+
+namespace PoolWatchdog {
+  template<typename T>
+  void init(T& spec) {
+    using namespace ThreadContextImpl::STL;
+
+    spec
+    /* ==> */
+    .it("should run the tasks on the pool", [] {
+      auto pool = ThreadPool::New(2);
+
+      auto p = Promise2::Promise<int>::New([] { return 1; }, ThreadPoolContext::New(pool));
+      for (int i = 0; i < 16; ++i) {
+        p = p.then([](int v) { return v + 1; }, ThreadPoolContext::New(pool));
+      }
+
+      if (17 != p.get())
+        throw AssertionFailed();
+    })
+    /* ==> */
+    .it("should report the stalled task with its label", [] {
+      auto reported = std::make_shared<std::vector<StalledTask>>();
+      auto mutex = std::make_shared<std::mutex>();
+
+      WatchdogOptions options;
+      options.threshold = std::chrono::milliseconds(20);
+      options.interval = std::chrono::milliseconds(5);
+      options.onStalled = [=](const StalledTask& task) {
+        std::lock_guard<std::mutex> _{ *mutex };
+        reported->push_back(task);
+      };
+
+      auto pool = ThreadPool::New(1, options);
+
+      Promise2::Promise<void>::New([] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+      }, ThreadPoolContext::New(pool), "watchdog.blocking").get();
+
+      std::lock_guard<std::mutex> _{ *mutex };
+      if (1 != reported->size() || "watchdog.blocking" != reported->front().label || reported->front().running < options.threshold)
+        throw AssertionFailed();
+
+      // settled within the task, the worker clears the stall right after
+      auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+      while (0 != pool->stalled() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+
+      if (0 != pool->stalled())
+        throw AssertionFailed();
+    })
+    /* ==> */
+    .it("should keep draining the queue with a compensating worker", [] {
+      WatchdogOptions options;
+      options.threshold = std::chrono::milliseconds(20);
+      options.interval = std::chrono::milliseconds(5);
+      options.compensate = true;
+      options.onStalled = [](const StalledTask& ) {};
+
+      auto pool = ThreadPool::New(1, options);
+      auto released = std::make_shared<std::promise<void>>();
+
+      // the only worker blocks till the task queued behind it runs
+      auto blocking = Promise2::Promise<bool>::New([=] {
+        return std::future_status::ready == released->get_future().wait_for(std::chrono::seconds(10));
+      }, ThreadPoolContext::New(pool));
+
+      Promise2::Promise<void>::New([=] { released->set_value(); }, ThreadPoolContext::New(pool)).get();
+
+      if (!blocking.get())
+        throw AssertionFailed();
+    });
+  }
+}
+
 TEST_ENTRY(CONTAINER_TYPE,
   SPEC_TFN(SpecFixedValue::init),
   SPEC_TFN(PromiseAPIsBase::init),
   SPEC_TFN(DataValidate::init),
   SPEC_TFN(OnRejectReturn::init),
-  SPEC_TFN(ConvertibleArgument::init));
+  SPEC_TFN(ConvertibleArgument::init),
+  SPEC_TFN(PromiseTimeout::init),
+  SPEC_TFN(PromiseWait::init),
+  SPEC_TFN(PromiseFuture::init),
+  SPEC_TFN(PromiseRetry::init),
+  SPEC_TFN(PromiseThenInline::init),
+  SPEC_TFN(MeasuredContext::init),
+  SPEC_TFN(SimulatedScheduling::init),
+  SPEC_TFN(LabelledCallbacks::init),
+  SPEC_TFN(PoolWatchdog::init));
   // disabled
   // SPEC_TFN(OnRejectImplicitlyResolved::init));
 
@@ -0,0 +1,100 @@
+/*
+ * Promise2
+ *
+ * Copyright (c) 2016 "0of" Magnus
+ * Licensed under the MIT license.
+ * https://github.com/0of/Promise2/blob/master/LICENSE
+ */
+
+#define PROMISE_CONTENTION_STATS 1
+
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <typeinfo>
+
+#include "entry.h"
+#include "Promise.h"
+
+class CurrentContext : public Promise2::ThreadContext {
+public:
+  static ThreadContext *New() {
+    return new CurrentContext;
+  }
+
+public:
+  virtual void scheduleToRun(std::function<void()>&& task) override {
+    task();
+  }
+};
+
+namespace PromiseContention {
+
+  // the stats of the type at the site, all zero if never spun
+  Promise2::Contention::SiteStats statsOf(const char *type, Promise2::Details::SpinSite site) {
+    for (const auto& stats : Promise2::Contention::snapshot()) {
+      if (0 == std::strcmp(type, stats.type) && site == stats.site) return stats;
+    }
+
+    return Promise2::Contention::SiteStats{ type, site, 0, 0, 0, 0 };
+  }
+
+  template<typename T>
+  void init(T& spec) {
+    spec
+    /* ==> */
+    .it("should aggregate the spun loops per type and site", [] {
+      struct Tag {};
+
+      for (int i = 0; i < 3; ++i) {
+        Promise2::Details::SpinProbe<Tag> probe{ Promise2::Details::SpinSite::Chain };
+        probe.spin();
+        probe.yield();
+        probe.spin();
+      }
+
+      {
+        // uncontended loops are not counted
+        Promise2::Details::SpinProbe<Tag> probe{ Promise2::Details::SpinSite::Settle };
+      }
+
+      auto chain = statsOf(typeid(Tag).name(), Promise2::Details::SpinSite::Chain);
+      if (3 != chain.contended || 6 != chain.spins || 3 != chain.yields)
+        throw AssertionFailed();
+
+      if (0 != statsOf(typeid(Tag).name(), Promise2::Details::SpinSite::Settle).contended)
+        throw AssertionFailed();
+
+      if (0 != std::strcmp("chain", Promise2::Contention::nameOf(chain.site)))
+        throw AssertionFailed();
+    })
+    /* ==> */
+    .it("should keep the counters consistent when settling races chaining", [] {
+      struct Raced {};
+
+      for (int i = 0; i < 2000; ++i) {
+        std::thread settling;
+
+        auto p = Promise2::Promise<Raced>::New([&](Promise2::PromiseDefer<Raced>&& deferred) {
+          settling = std::thread{ [deferred = std::move(deferred)] () mutable { deferred.setResult(Raced{}); } };
+        }, CurrentContext::New());
+
+        auto chained = p.then([](Raced ) { return 1; }, CurrentContext::New());
+        settling.join();
+
+        if (1 != chained.get())
+          throw AssertionFailed();
+      }
+
+      // whether the loops spun depends on the scheduler, their counters agree anyway
+      for (auto site : { Promise2::Details::SpinSite::Settle, Promise2::Details::SpinSite::Chain }) {
+        auto stats = statsOf(typeid(Raced).name(), site);
+        if (stats.contended > stats.spins || stats.yields > stats.spins)
+          throw AssertionFailed();
+      }
+    });
+  }
+}
+
+TEST_ENTRY(CONTAINER_TYPE,
+  SPEC_TFN(PromiseContention::init));
@@ -0,0 +1,124 @@
+/*
+ * Promise2
+ *
+ * Copyright (c) 2016 "0of" Magnus
+ * Licensed under the MIT license.
+ * https://github.com/0of/Promise2/blob/master/LICENSE
+ */
+
+#define PROMISE_LEAK_DETECTOR 1
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "entry.h"
+#include "Promise.h"
+
+class CurrentContext : public Promise2::ThreadContext {
+public:
+  static ThreadContext *New() {
+    return new CurrentContext;
+  }
+
+public:
+  virtual void scheduleToRun(std::function<void()>&& task) override {
+    task();
+  }
+};
+
+namespace PromiseDiagnostics {
+  using Promise2::Diagnostics::NodeKind;
+  using Promise2::Diagnostics::liveNodes;
+  using Promise2::Diagnostics::unconsumedValues;
+
+  template<typename T>
+  void init(T& spec) {
+    spec
+    /* ==> */
+    .it("should count the live nodes by kind", [] {
+      auto resolved = liveNodes(NodeKind::Resolved);
+      auto task = liveNodes(NodeKind::Task);
+      auto then = liveNodes(NodeKind::Then);
+      auto deferred = liveNodes(NodeKind::Deferred);
+
+      {
+        auto p = Promise2::Promise<std::int32_t>::Resolved(1);
+        // the ones ran and chained are released unless held
+        auto q = Promise2::Promise<std::int32_t>::New([] { return 1; }, CurrentContext::New());
+        auto r = q.then([](std::int32_t v) { return v + 1; }, CurrentContext::New());
+        auto s = r.then([](Promise2::PromiseDefer<void>&& deferred, std::int32_t ) { deferred.setResult(); }, CurrentContext::New());
+
+        if (resolved + 1 != liveNodes(NodeKind::Resolved) || task + 1 != liveNodes(NodeKind::Task) ||
+            then + 1 != liveNodes(NodeKind::Then) || deferred + 1 != liveNodes(NodeKind::Deferred))
+          throw AssertionFailed();
+
+        if (!s.isFulfilled())
+          throw AssertionFailed();
+      }
+
+      if (resolved != liveNodes(NodeKind::Resolved) || task != liveNodes(NodeKind::Task) || then != liveNodes(NodeKind::Then) ||
+          deferred != liveNodes(NodeKind::Deferred))
+        throw AssertionFailed();
+    })
+    /* ==> */
+    .it("should count the values settled but not chained yet", [] {
+      auto unconsumed = unconsumedValues();
+
+      {
+        auto p = Promise2::Promise<std::int32_t>::New([] { return 1; }, CurrentContext::New());
+        if (unconsumed + 1 != unconsumedValues())
+          throw AssertionFailed();
+
+        // handed over, the `then` holds its own till chained
+        auto q = p.then([](std::int32_t ) {}, CurrentContext::New());
+        if (unconsumed + 1 != unconsumedValues())
+          throw AssertionFailed();
+
+        q.then([] {}, CurrentContext::New());
+      }
+
+      {
+        // never chained
+        auto p = Promise2::Promise<std::int32_t>::New([] { return 1; }, CurrentContext::New());
+      }
+
+      if (unconsumed != unconsumedValues())
+        throw AssertionFailed();
+    })
+    /* ==> */
+    .it("should free an unchained bounded recursion paused at the mark", [] {
+      auto recursion = liveNodes(NodeKind::Recursion);
+      std::vector<std::int32_t> values(64, 1);
+
+      {
+        // paused within the iteration, nothing would ever resume it
+        auto p = Promise2::RecursionPromise<std::int32_t>::Iterate(values.begin(), values.end(), 4, CurrentContext::New());
+        if (recursion + 1 != liveNodes(NodeKind::Recursion))
+          throw AssertionFailed();
+      }
+
+      if (recursion != liveNodes(NodeKind::Recursion))
+        throw AssertionFailed();
+    })
+    /* ==> */
+    .it("should dump the nodes alive past the threshold", [] {
+      auto p = Promise2::Promise<std::int32_t>::New([] { return 1; }, CurrentContext::New());
+
+      std::ostringstream recent;
+      if (0 != Promise2::Diagnostics::dumpLeaks(recent, std::chrono::hours(1)) || !recent.str().empty())
+        throw AssertionFailed();
+
+      std::ostringstream all;
+      if (0 == Promise2::Diagnostics::dumpLeaks(all, std::chrono::milliseconds(0)))
+        throw AssertionFailed();
+
+      if (std::string::npos == all.str().find("task node"))
+        throw AssertionFailed();
+    });
+  }
+}
+
+TEST_ENTRY(CONTAINER_TYPE,
+  SPEC_TFN(PromiseDiagnostics::init));
@@ -0,0 +1,106 @@
+/*
+ * Promise2
+ *
+ * Copyright (c) 2016 "0of" Magnus
+ * Licensed under the MIT license.
+ * https://github.com/0of/Promise2/blob/master/LICENSE
+ */
+
+#define PROMISE_TRACING 1
+
+#include <cstdint>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "entry.h"
+#include "Promise.h"
+
+class CurrentContext : public Promise2::ThreadContext {
+public:
+  static ThreadContext *New() {
+    return new CurrentContext;
+  }
+
+public:
+  virtual void scheduleToRun(std::function<void()>&& task) override {
+    task();
+  }
+};
+
+namespace PromiseTracing {
+
+  std::size_t occurrences(const std::string& trace, const std::string& text) {
+    std::size_t count = 0;
+    for (auto found = trace.find(text); found != std::string::npos; found = trace.find(text, found + text.size())) {
+      ++count;
+    }
+
+    return count;
+  }
+
+  std::set<std::string> threadIds() {
+    std::ostringstream out;
+    Promise2::Tracing::dump(out);
+
+    auto trace = out.str();
+    std::string tid{ "\"tid\":" };
+
+    std::set<std::string> ids;
+    for (auto found = trace.find(tid); found != std::string::npos; found = trace.find(tid, found + tid.size())) {
+      auto from = found + tid.size();
+      ids.insert(trace.substr(from, trace.find_first_not_of("0123456789", from) - from));
+    }
+
+    return ids;
+  }
+
+  template<typename T>
+  void init(T& spec) {
+    spec
+    /* ==> */
+    .it("should record the lifecycle as chrome trace events", [] {
+      // the run ends after the settled value woken up the waiting thread, so run inline here
+      auto p = Promise2::Promise<std::int32_t>::New([] { return 1; }, CurrentContext::New()).
+        then([](std::int32_t v) { return v + 1; }, CurrentContext::New());
+
+      if (2 != p.get())
+        throw AssertionFailed();
+
+      std::ostringstream out;
+      Promise2::Tracing::dump(out);
+
+      auto trace = out.str();
+
+      if (0 != trace.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["))
+        throw AssertionFailed();
+
+      for (auto name : { "create", "chain", "fulfill", "schedule" }) {
+        if (0 == occurrences(trace, std::string{ "\"name\":\"" } + name + '"'))
+          throw AssertionFailed();
+      }
+
+      // every run has its end
+      auto begins = occurrences(trace, "\"name\":\"run\",\"cat\":\"promise\",\"ph\":\"B\"");
+      if (begins < 2 || begins != occurrences(trace, "\"name\":\"run\",\"cat\":\"promise\",\"ph\":\"E\""))
+        throw AssertionFailed();
+    })
+    /* ==> */
+    .it("should take over the buffer of an exited thread", [] {
+      auto before = threadIds();
+
+      for (std::int32_t i = 0; i < 4; ++i) {
+        std::thread{ [] {
+          Promise2::Promise<std::int32_t>::New([] { return 1; }, CurrentContext::New()).get();
+        } }.join();
+      }
+
+      if (threadIds().size() > before.size() + 1)
+        throw AssertionFailed();
+    });
+  }
+}
+
+TEST_ENTRY(CONTAINER_TYPE,
+  SPEC_TFN(PromiseTracing::init));
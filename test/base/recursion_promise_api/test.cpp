@@ -7,6 +7,9 @@
  */
 
 #include <atomic>
+#include <cstdint>
+#include <numeric>
+#include <thread>
 #include <vector>
 
 #include "entry.h"
@@ -29,6 +32,32 @@ using STLThreadContext = ThreadContextImpl::STL::DetachedThreadContext;
 
 namespace RecursionAPIsBase {
 
+  // counts the dereferences to track how many values have been produced
+  class CountingIterator {
+  private:
+    std::int32_t _index;
+    std::shared_ptr<std::atomic<std::int32_t>> _produced;
+
+  public:
+    CountingIterator(std::int32_t index, const std::shared_ptr<std::atomic<std::int32_t>>& produced)
+      : _index{ index }
+      , _produced{ produced }
+    {}
+
+  public:
+    bool operator != (const CountingIterator& i) { return i._index != _index; }
+
+    CountingIterator& operator++ () {
+      ++_index;
+      return *this;
+    }
+
+    std::int32_t operator *() const {
+      ++*_produced;
+      return _index;
+    }
+  };
+
   // IntputIterator
   class UserIterator {
   public:
@@ -193,6 +222,418 @@ namespace RecursionAPIsBase {
                                        else { notifier->fail(std::make_exception_ptr(AssertionFailed())); }
                                        return Promise2::Promise<void>::Rejected(e); },
             STLThreadContext::New());
+    })
+    /* ==> */
+    .it("should iterate random access range in chunks under STL thread context", [](const LTest::SharedCaseEndNotifier& notifier){
+      std::vector<std::int64_t> values(1 << 20);
+      std::iota(values.begin(), values.end(), 1);
+
+      auto shared = std::make_shared<std::vector<std::int64_t>>(std::move(values));
+      auto counter = std::make_shared<std::atomic<std::int64_t>>(0);
+      auto sum = std::make_shared<std::atomic<std::int64_t>>(0);
+
+      Promise2::RecursionPromise<std::int64_t>::Iterate(shared->begin(), shared->end(), STLThreadContext::New()).
+      then([=](std::int64_t v) { ++*counter; *sum += v; },
+           [=](std::exception_ptr) { notifier->fail(std::make_exception_ptr(AssertionFailed())); return Promise2::RecursionPromise<void>(); },
+           context::New()).
+      final([=]() { 
+        const std::int64_t n = shared->size();
+        if (n == *counter && n * (n + 1) / 2 == *sum) { notifier->done(); }
+        else notifier->fail(std::make_exception_ptr(AssertionFailed())); }, 
+            [=](std::exception_ptr) { notifier->fail(std::make_exception_ptr(AssertionFailed())); return Promise2::Promise<void>(); },
+            context::New());
+    })
+    /* ==> */
+    .it("should block till finished under STL thread context", [] {
+      auto counter = std::make_shared<std::atomic<std::int32_t>>(0);
+
+      Promise2::RecursionPromise<std::int32_t>::Iterate(UserIterator(false), UserIterator(true), STLThreadContext::New()).
+      then([=](std::int32_t ) { ++*counter; }, CurrentContext::New()).get();
+
+      if (UserIterator::max != *counter)
+        throw AssertionFailed();
+    })
+    /* ==> */
+    .it("should rethrow when deref throws exception under STL thread context", [] {
+      auto p = Promise2::RecursionPromise<std::int32_t>::Iterate(UserExceptionIterator(false), UserExceptionIterator(true), STLThreadContext::New());
+
+      try {
+        p.get();
+      } catch (const UserException&) {
+        return;
+      }
+
+      throw AssertionFailed();
+    })
+    /* ==> */
+    .it("should emit in order while running in parallel under STL thread context", [](const LTest::SharedCaseEndNotifier& notifier){
+      constexpr std::int32_t count = 500;
+
+      auto produced = std::make_shared<std::atomic<std::int32_t>>(0);
+      auto emitted = std::make_shared<std::vector<std::int32_t>>();
+
+      Promise2::RecursionPromise<std::int32_t>::Iterate(CountingIterator(0, produced), CountingIterator(count, produced), STLThreadContext::New()).
+      thenOrdered(8, [](std::int32_t v) {
+        // finish out of order
+        std::this_thread::sleep_for(std::chrono::microseconds((v * 7919) % 200));
+        return v;
+      }, STLThreadContext::New()).
+      then([=](std::int32_t v) { emitted->push_back(v); }, CurrentContext::New()).
+      final([=]() {
+        std::vector<std::int32_t> expected(count);
+        std::iota(expected.begin(), expected.end(), 0);
+
+        if (expected == *emitted) { notifier->done(); }
+        else notifier->fail(std::make_exception_ptr(AssertionFailed())); },
+            [=](std::exception_ptr) { notifier->fail(std::make_exception_ptr(AssertionFailed())); return Promise2::Promise<void>(); },
+            context::New());
+    })
+    /* ==> */
+    .it("should emit in order under current thread context", [] {
+      constexpr std::int32_t count = 100;
+
+      auto produced = std::make_shared<std::atomic<std::int32_t>>(0);
+      auto emitted = std::make_shared<std::vector<std::int32_t>>();
+
+      // the window slides within the values run inline
+      Promise2::RecursionPromise<std::int32_t>::Iterate(CountingIterator(0, produced), CountingIterator(count, produced), CurrentContext::New()).
+      thenOrdered(4, [](std::int32_t v) { return v; }, CurrentContext::New()).
+      then([=](std::int32_t v) { emitted->push_back(v); }, CurrentContext::New()).get();
+
+      std::vector<std::int32_t> expected(count);
+      std::iota(expected.begin(), expected.end(), 0);
+
+      if (expected != *emitted)
+        throw AssertionFailed();
+    })
+    /* ==> */
+    .it("should relay the recovery recursion of the ordered thenable under current thread context", [] {
+      constexpr std::int32_t count = 10;
+      constexpr std::int32_t recovered = 3;
+
+      auto produced = std::make_shared<std::atomic<std::int32_t>>(0);
+      auto emitted = std::make_shared<std::vector<std::int32_t>>();
+
+      Promise2::RecursionPromise<std::int32_t>::Iterate(CountingIterator(0, produced), CountingIterator(count, produced), CurrentContext::New()).
+      then([](std::int32_t v) {
+        if (count / 2 == v) throw UserException();
+        return v;
+      }, CurrentContext::New()).
+      thenOrdered(2, [](std::int32_t v) { return v; },
+                  [=](std::exception_ptr) {
+                    return Promise2::RecursionPromise<std::int32_t>::Iterate(CountingIterator(count, produced), CountingIterator(count + recovered, produced), CurrentContext::New());
+                  }, CurrentContext::New()).
+      then([=](std::int32_t v) { emitted->push_back(v); }, CurrentContext::New()).get();
+
+      // relayed inline in place of the rejected one
+      const std::vector<std::int32_t> expected{ 0, 1, 2, 3, 4, 10, 11, 12, 6, 7, 8, 9 };
+      if (expected != *emitted)
+        throw AssertionFailed();
+    })
+    /* ==> */
+    .it("should reduce random access range under STL thread context", [](const LTest::SharedCaseEndNotifier& notifier){
+      std::vector<std::int64_t> values(1 << 20);
+      std::iota(values.begin(), values.end(), 1);
+
+      auto shared = std::make_shared<std::vector<std::int64_t>>(std::move(values));
+
+      Promise2::RecursionPromise<std::int64_t>::Iterate(shared->begin(), shared->end(), STLThreadContext::New()).
+      reduce(std::int64_t{ 0 }, [](std::int64_t acc, std::int64_t v) { return acc + v; }, STLThreadContext::New()).
+      then([=](std::int64_t sum) {
+        const std::int64_t n = shared->size();
+        if (n * (n + 1) / 2 == sum) { notifier->done(); }
+        else notifier->fail(std::make_exception_ptr(AssertionFailed())); },
+           [=](std::exception_ptr) { notifier->fail(std::make_exception_ptr(AssertionFailed())); },
+           context::New());
+    })
+    /* ==> */
+    .it("should reduce after every value of a parallel thenable under STL thread context", [] {
+      constexpr std::int32_t count = 200;
+      constexpr std::int32_t rounds = 10;
+
+      for (std::int32_t round = 0; round < rounds; ++round) {
+        auto produced = std::make_shared<std::atomic<std::int32_t>>(0);
+
+        // a task per value, the finish is scheduled apart from them
+        auto sum = Promise2::RecursionPromise<std::int32_t>::Iterate(CountingIterator(1, produced), CountingIterator(count + 1, produced), CurrentContext::New()).
+          then([](std::int32_t v) {
+            // the finish task gets ahead
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            return std::int64_t{ v };
+          }, STLThreadContext::New()).
+          reduce(std::int64_t{ 0 }, [](std::int64_t acc, std::int64_t v) { return acc + v; }, STLThreadContext::New()).get();
+
+        if (std::int64_t{ count } * (count + 1) / 2 != sum)
+          throw AssertionFailed();
+      }
+    })
+    /* ==> */
+    .it("should reject the reduced promise when deref throws exception", [] {
+      auto reduced = Promise2::RecursionPromise<std::int32_t>::Iterate(UserExceptionIterator(false), UserExceptionIterator(true), CurrentContext::New()).
+      reduce(std::vector<std::int32_t>{},
+             [](std::vector<std::int32_t> acc, std::int32_t v) { acc.push_back(v); return acc; },
+             [](std::vector<std::int32_t> acc, std::vector<std::int32_t> other) { acc.insert(acc.end(), other.begin(), other.end()); return acc; },
+             CurrentContext::New());
+
+      try {
+        reduced.get();
+      } catch (const UserException&) {
+        return;
+      }
+
+      throw AssertionFailed();
+    })
+    /* ==> */
+    .it("should forward values pushed by several threads under STL thread context", [](const LTest::SharedCaseEndNotifier& notifier){
+      constexpr std::int32_t producers = 4;
+      constexpr std::int32_t count = 1000;
+
+      auto counter = std::make_shared<std::atomic<std::int32_t>>(0);
+      auto sum = std::make_shared<std::atomic<std::int64_t>>(0);
+
+      Promise2::RecursionPromise<std::int32_t>::Deferred([](Promise2::RecursionPromiseDefer<std::int32_t> defer) {
+        std::thread([=]() mutable {
+          std::vector<std::thread> threads;
+          for (std::int32_t p = 0; p < producers; ++p) {
+            threads.emplace_back([=]() mutable {
+              for (std::int32_t i = 1; i <= count; ++i) defer.push(i);
+            });
+          }
+
+          for (auto& t : threads) t.join();
+          defer.finish();
+        }).detach();
+      }, STLThreadContext::New()).
+      then([=](std::int32_t v) { ++*counter; *sum += v; }, CurrentContext::New()).
+      final([=]() {
+        if (producers * count == *counter && producers * count * (count + 1) / 2 == *sum) { notifier->done(); }
+        else notifier->fail(std::make_exception_ptr(AssertionFailed())); },
+            [=](std::exception_ptr) { notifier->fail(std::make_exception_ptr(AssertionFailed())); return Promise2::Promise<void>(); },
+            context::New());
+    })
+    /* ==> */
+    .it("should reject when deferred recursion failed", [] {
+      auto discarded = std::make_shared<bool>(false);
+
+      auto p = Promise2::RecursionPromise<std::int32_t>::Deferred([=](Promise2::RecursionPromiseDefer<std::int32_t> defer) {
+        defer.push(0);
+        defer.fail(std::make_exception_ptr(UserException()));
+
+        // no more values after failed
+        try {
+          defer.push(1);
+        } catch (const std::logic_error&) {
+          *discarded = true;
+        }
+      }, CurrentContext::New());
+
+      try {
+        p.get();
+      } catch (const UserException&) {
+        if (*discarded) return;
+      }
+
+      throw AssertionFailed();
+    })
+    /* ==> */
+    .it("should halt the iteration once taken", [](const LTest::SharedCaseEndNotifier& notifier){
+      auto produced = std::make_shared<std::atomic<std::int32_t>>(0);
+      auto taken = std::make_shared<std::vector<std::int32_t>>();
+
+      // hardly ever reaches the end unless halted
+      Promise2::RecursionPromise<std::int32_t>::Iterate(CountingIterator(0, produced), CountingIterator(INT32_MAX, produced), STLThreadContext::New()).
+      map([](std::int32_t v) { return v * 2; }).
+      filter([](std::int32_t v) { return 0 == v % 3; }).
+      take(10).
+      on(CurrentContext::New()).
+      then([=](std::int32_t v) { taken->push_back(v); }, CurrentContext::New()).
+      final([=]() {
+        const std::vector<std::int32_t> expected{ 0, 6, 12, 18, 24, 30, 36, 42, 48, 54 };
+        if (expected == *taken && INT32_MAX > *produced) { notifier->done(); }
+        else notifier->fail(std::make_exception_ptr(AssertionFailed())); },
+            [=](std::exception_ptr) { notifier->fail(std::make_exception_ptr(AssertionFailed())); return Promise2::Promise<void>(); },
+            context::New());
+    })
+    /* ==> */
+    .it("should flatten the fused values under STL thread context", [](const LTest::SharedCaseEndNotifier& notifier){
+      auto counter = std::make_shared<std::atomic<std::int32_t>>(0);
+
+      Promise2::RecursionPromise<std::int32_t>::Iterate(UserIterator(false), UserIterator(true), STLThreadContext::New()).
+      flatMap([](std::int32_t v) { return std::vector<std::int64_t>(v + 1, v); }).
+      on(CurrentContext::New()).
+      then([=](std::int64_t ) { ++*counter; }, CurrentContext::New()).
+      final([=]() {
+        // 1 + 2 + 3
+        if (6 == *counter) { notifier->done(); }
+        else notifier->fail(std::make_exception_ptr(AssertionFailed())); },
+            [=](std::exception_ptr) { notifier->fail(std::make_exception_ptr(AssertionFailed())); return Promise2::Promise<void>(); },
+            context::New());
+    })
+    /* ==> */
+    .it("should deliver values in chunks under STL thread context", [](const LTest::SharedCaseEndNotifier& notifier){
+      auto gathered = std::make_shared<std::vector<std::int32_t>>();
+      auto oversized = std::make_shared<std::atomic_bool>(false);
+
+      // the input iterator yields in order
+      Promise2::RecursionPromise<std::int32_t>::Iterate(UserIterator(false), UserIterator(true), STLThreadContext::New()).
+      then([=](std::int32_t v) { return v; }, CurrentContext::New()).
+      chunked(2).
+      then([=](const std::vector<std::int32_t>& chunk) {
+        if (chunk.empty() || chunk.size() > 2) *oversized = true;
+        gathered->insert(gathered->end(), chunk.begin(), chunk.end());
+      }, CurrentContext::New()).
+      final([=]() {
+        if (!*oversized && std::vector<std::int32_t>{ 0, 1, 2 } == *gathered) { notifier->done(); }
+        else notifier->fail(std::make_exception_ptr(AssertionFailed())); },
+            [=](std::exception_ptr) { notifier->fail(std::make_exception_ptr(AssertionFailed())); return Promise2::Promise<void>(); },
+            context::New());
+    })
+    /* ==> */
+    .it("should reject the chunk after the gathered ones", [](const LTest::SharedCaseEndNotifier& notifier){
+      auto gathered = std::make_shared<std::int32_t>(0);
+
+      Promise2::RecursionPromise<std::int32_t>::Iterate(UserExceptionIterator(false), UserExceptionIterator(true), CurrentContext::New()).
+      chunked(16).
+      then([=](const std::vector<std::int32_t>& chunk) { *gathered += static_cast<std::int32_t>(chunk.size()); },
+           [=](std::exception_ptr) { return Promise2::RecursionPromise<void>(); },
+           CurrentContext::New()).
+      final([=]() { notifier->fail(std::make_exception_ptr(AssertionFailed())); },
+            [=](std::exception_ptr e) {
+              try {
+                std::rethrow_exception(e);
+              } catch (const UserException&) {
+                // the value yielded before the exception is still delivered
+                if (1 == *gathered) notifier->done();
+                else notifier->fail(std::make_exception_ptr(AssertionFailed()));
+              } catch (...) {
+                notifier->fail(std::make_exception_ptr(AssertionFailed()));
+              }
+              return Promise2::Promise<void>(); },
+            context::New());
+    })
+    /* ==> */
+    .it("should suspend at the high-water mark under STL thread context", [](const LTest::SharedCaseEndNotifier& notifier){
+      constexpr std::int32_t count = 2000;
+      constexpr std::size_t highWaterMark = 16;
+
+      auto produced = std::make_shared<std::atomic<std::int32_t>>(0);
+      auto consumed = std::make_shared<std::atomic<std::int32_t>>(0);
+      auto overflowed = std::make_shared<std::atomic_bool>(false);
+
+      Promise2::RecursionPromise<std::int32_t>::Iterate(CountingIterator(0, produced), CountingIterator(count, produced), highWaterMark, STLThreadContext::New()).
+      then([=](std::int32_t ) {
+        // the value being consumed is counted as pending as well
+        if (static_cast<std::size_t>(*produced - *consumed) > highWaterMark) *overflowed = true;
+
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+
+        // the final notification does not wait for the detached consumers
+        if (count == ++*consumed) {
+          if (*overflowed) notifier->fail(std::make_exception_ptr(AssertionFailed()));
+          else notifier->done();
+        }
+      }, STLThreadContext::New());
+    })
+    /* ==> */
+    .it("should keep the order of values buffered beyond the ring", [](const LTest::SharedCaseEndNotifier& notifier){
+      constexpr std::int32_t count = RECURSION_VALUE_RING_SIZE * 4 + 1;
+
+      auto produced = std::make_shared<std::atomic<std::int32_t>>(0);
+      auto next = std::make_shared<std::int32_t>(0);
+      auto ordered = std::make_shared<bool>(true);
+
+      // iterated before chained, held values fall back to the heap
+      auto p = Promise2::RecursionPromise<std::int32_t>::Iterate(CountingIterator(0, produced), CountingIterator(count, produced), CurrentContext::New());
+
+      p.then([=](std::int32_t v) { if (v != (*next)++) *ordered = false; }, CurrentContext::New()).
+      final([=]() {
+              if (*ordered && count == *next) notifier->done();
+              else notifier->fail(std::make_exception_ptr(AssertionFailed()));
+            },
+            [=](std::exception_ptr) { notifier->fail(std::make_exception_ptr(AssertionFailed())); },
+            CurrentContext::New());
+    })
+    /* ==> */
+    .it("should relay the recovery recursion when rejected midway under STL thread context", [](const LTest::SharedCaseEndNotifier& notifier){
+      constexpr std::int32_t count = 20000;
+      constexpr std::int32_t recovered = 10000;
+
+      auto produced = std::make_shared<std::atomic<std::int32_t>>(0);
+      auto counter = std::make_shared<std::atomic<std::int32_t>>(0);
+
+      Promise2::RecursionPromise<std::int32_t>::Iterate(CountingIterator(0, produced), CountingIterator(count, produced), STLThreadContext::New()).
+      then([](std::int32_t v) {
+        if (count / 2 == v) throw UserException();
+        return v;
+      }, CurrentContext::New()).
+      then([](std::int32_t v) { return v; },
+           [=](std::exception_ptr) {
+             // relayed while the rest of the upstream still running
+             return Promise2::RecursionPromise<std::int32_t>::Iterate(CountingIterator(0, produced), CountingIterator(recovered, produced), STLThreadContext::New());
+           }, CurrentContext::New()).
+      then([=](std::int32_t ) { ++*counter; }, CurrentContext::New()).
+      final([=]() {
+              // every value is delivered before finished
+              if (count - 1 + recovered == *counter) notifier->done();
+              else notifier->fail(std::make_exception_ptr(AssertionFailed()));
+            },
+            [=](std::exception_ptr) { notifier->fail(std::make_exception_ptr(AssertionFailed())); },
+            CurrentContext::New());
+    })
+    /* ==> */
+    .it("should reject when the recovery recursion failed under STL thread context", [] {
+      constexpr std::int32_t count = 10000;
+      constexpr std::int32_t rounds = 16;
+
+      for (std::int32_t round = 0; round < rounds; ++round) {
+        auto produced = std::make_shared<std::atomic<std::int32_t>>(0);
+        auto counter = std::make_shared<std::atomic<std::int32_t>>(0);
+
+        auto p = Promise2::RecursionPromise<std::int32_t>::Iterate(CountingIterator(0, produced), CountingIterator(count, produced), STLThreadContext::New()).
+          then([=](std::int32_t v) {
+            if (count / 2 + round == v) throw UserException();
+            return v;
+          }, CurrentContext::New()).
+          then([](std::int32_t v) { return v; },
+               [](std::exception_ptr) {
+                 // yields one value then fails
+                 return Promise2::RecursionPromise<std::int32_t>::Iterate(UserExceptionIterator(false), UserExceptionIterator(true), STLThreadContext::New());
+               }, CurrentContext::New()).
+          then([=](std::int32_t ) { ++*counter; }, CurrentContext::New());
+
+        try {
+          p.get();
+        } catch (const UserException&) {
+          if (count == *counter) continue;
+        }
+
+        throw AssertionFailed();
+      }
+    })
+    /* ==> */
+    .it("should measure the labelled iteration and every labelled value", [] {
+      constexpr std::int32_t count = 1000;
+
+      auto produced = std::make_shared<std::atomic<std::int32_t>>(0);
+
+      Promise2::RecursionPromise<std::int32_t>::Iterate(CountingIterator(0, produced), CountingIterator(count, produced), STLThreadContext::New(), "recursion.iterate").
+        then([](std::int32_t ) {}, CurrentContext::New(), "recursion.then").get();
+
+      std::uint64_t iterations = 0;
+      std::uint64_t values = 0;
+
+      // the iterating task is recorded once returned, which may be after finished
+      for (std::int32_t i = 0; 0 == iterations && i < 1000; ++i) {
+        for (const auto& snapshot : Promise2::Labels::snapshot()) {
+          if ("recursion.iterate" == snapshot.name) iterations = snapshot.invocations;
+          if ("recursion.then" == snapshot.name) values = snapshot.invocations;
+        }
+
+        if (0 == iterations) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+
+      if (0 == iterations || count != values)
+        throw AssertionFailed();
     });
   }
 